@@ -0,0 +1,87 @@
+/**
+ * @file bench_chi2.cpp
+ * @brief throughput of the chi2 kernel on LTP histograms against the former per bin code
+ *
+ * usage: bench_chi2 [number of histogram pairs]
+ */
+#include "chi2kernel.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+const int nbBins=256;
+
+//chi2 distance as computed by Asari::mergeUsingTexture before the kernel
+static void powChi2(const int* hist1,double nbPixels1,const int* hist2,double nbPixels2,double& dist,double& nbNonZero){
+    for(int i=0;i<nbBins;i++){
+        double h1=hist1[i]/nbPixels1;
+        double h2=hist2[i]/nbPixels2;
+        if(h1>0||h2>0){
+            dist+=pow(h1-h2,2)/(h1+h2);
+            nbNonZero++;
+        }
+    }
+}
+
+//random histogram of nbPixels samples over a few dominant bins, as LTP histograms of superpixels
+static void randomHistogram(int* hist,int nbPixels){
+    for(int i=0;i<nbBins;i++) hist[i]=0;
+    for(int p=0;p<nbPixels;p++){
+        hist[rand()%4==0 ? rand()%nbBins : (rand()%16)*17]++;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int nbPairs=argc>1 ? atoi(argv[1]) : 20000;
+    const int nbRuns=20;
+
+    srand(0);
+    vector<int> hists(2*nbPairs*nbBins);
+    vector<double> sizes(2*nbPairs);
+    for(int h=0;h<2*nbPairs;h++){
+        sizes[h]=20+rand()%500;
+        randomHistogram(&hists[h*nbBins],sizes[h]);
+    }
+
+    vector<double> reference(nbPairs);
+    chrono::steady_clock::time_point start=chrono::steady_clock::now();
+    for(int run=0;run<nbRuns;run++){
+        for(int p=0;p<nbPairs;p++){
+            double dist=0,nbNonZero=0;
+            powChi2(&hists[2*p*nbBins],sizes[2*p],&hists[(2*p+1)*nbBins],sizes[2*p+1],dist,nbNonZero);
+            reference[p]=dist/nbNonZero;
+        }
+    }
+    double seconds=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    cout << "pow   : " << seconds*1e9/nbRuns/nbPairs << " ns/distance" << endl;
+
+    const char* names[3]={"scalar","sse4.1","avx2  "};
+    vector<double> scalar(nbPairs);
+    for(int level=SIMD_SCALAR;level<=bestSimdLevel();level++){
+        vector<double> res(nbPairs);
+        start=chrono::steady_clock::now();
+        for(int run=0;run<nbRuns;run++){
+            for(int p=0;p<nbPairs;p++){
+                double dist=0,nbNonZero=0;
+                AccumulateChi2(SimdLevel(level),&hists[2*p*nbBins],sizes[2*p],&hists[(2*p+1)*nbBins],sizes[2*p+1],nbBins,dist,nbNonZero);
+                res[p]=dist/nbNonZero;
+            }
+        }
+        seconds=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+        if(level==SIMD_SCALAR) scalar=res;
+
+        double maxError=0;
+        for(int p=0;p<nbPairs;p++) maxError=max(maxError,fabs(res[p]-reference[p])/reference[p]);
+        cout << names[level] << ": " << seconds*1e9/nbRuns/nbPairs << " ns/distance, "
+             << (res==scalar ? "identical to scalar" : "DIFFERENT from scalar")
+             << ", maximal relative difference with pow: " << maxError << endl;
+    }
+
+    return 0;
+}
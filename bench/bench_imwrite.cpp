@@ -0,0 +1,83 @@
+/**
+ * @file bench_imwrite.cpp
+ * @brief throughput of the color ImWrite path against the former byte by byte putc writer
+ *
+ * usage: bench_imwrite [megapixels] [output file]
+ */
+#include "limace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+//writer of ImWrite before the row buffer: three putc calls per pixel
+static void putcWrite(Image im,const char fileName[]){
+    FILE* fid=fopen(fileName,"wb");
+    if(fid==NULL) return;
+    int nbRow=ImNbRow(im),nbCol=ImNbCol(im);
+    unsigned char **R=ImGetR(im),**G=ImGetG(im),**B=ImGetB(im);
+    fprintf(fid,"%s\n%d %d\n%d\n","P6",nbCol,nbRow,255);
+    for(int i=0;i<nbRow;i++){
+        for(int j=0;j<nbCol;j++){
+            if(putc(R[i][j],fid)==EOF || putc(G[i][j],fid)==EOF || putc(B[i][j],fid)==EOF){
+                fclose(fid);
+                return;
+            }
+        }
+    }
+    fclose(fid);
+}
+
+static double megabytesPerSecond(void (*writer)(Image,const char[]),Image im,const char fileName[]){
+    const int nbRuns=5;
+    chrono::steady_clock::time_point start=chrono::steady_clock::now();
+    for(int run=0;run<nbRuns;run++){
+        writer(im,fileName);
+    }
+    double seconds=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    return nbRuns*3.0*ImNbRow(im)*ImNbCol(im)/1e6/seconds;
+}
+
+static vector<char> readFile(const char fileName[]){
+    vector<char> content;
+    FILE* fid=fopen(fileName,"rb");
+    if(fid==NULL) return content;
+    int c;
+    while((c=getc(fid))!=EOF) content.push_back((char)c);
+    fclose(fid);
+    return content;
+}
+
+int main(int argc, char *argv[])
+{
+    double megapixels=argc>1 ? atof(argv[1]) : 4;
+    const char* fileName=argc>2 ? argv[2] : "bench_imwrite.ppm";
+    int nbCol=2000;
+    int nbRow=megapixels*1e6/nbCol;
+
+    Image im=ImAlloc(Col0r,nbRow,nbCol);
+    unsigned char **R=ImGetR(im),**G=ImGetG(im),**B=ImGetB(im);
+    srand(0);
+    for(int i=0;i<nbRow;i++){
+        for(int j=0;j<nbCol;j++){
+            R[i][j]=rand()&0xFF;
+            G[i][j]=rand()&0xFF;
+            B[i][j]=rand()&0xFF;
+        }
+    }
+
+    cout << "putc  : " << megabytesPerSecond(putcWrite,im,fileName) << " MB/s" << endl;
+    vector<char> reference=readFile(fileName);
+    cout << "fwrite: " << megabytesPerSecond(ImWrite,im,fileName) << " MB/s" << endl;
+    vector<char> written=readFile(fileName);
+    cout << "identical files: " << (reference==written ? "yes" : "no") << endl;
+
+    remove(fileName);
+    ImFree(&im);
+    return 0;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file bench_lab.cpp
+ * @brief throughput of the sRGB to CIELAB conversion modes and error of LAB_FAST
+ *
+ * usage: bench_lab [megapixels]
+ */
+#include "labconverter.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+static double megapixelsPerSecond(const LabConverter& converter,const vector<unsigned int>& ubuff,
+                                  vector<double>& l,vector<double>& a,vector<double>& b){
+    const int nbRuns=5;
+    chrono::steady_clock::time_point start=chrono::steady_clock::now();
+    for(int run=0;run<nbRuns;run++){
+        converter.convert(ubuff.data(),ubuff.size(),l.data(),a.data(),b.data());
+    }
+    double seconds=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+    return nbRuns*ubuff.size()/1e6/seconds;
+}
+
+int main(int argc, char *argv[])
+{
+    double megapixels=argc>1 ? atof(argv[1]) : 4;
+    int sz=megapixels*1e6;
+
+    vector<unsigned int> ubuff(sz);
+    srand(0);
+    for(int i=0;i<sz;i++){
+        ubuff[i]=((rand()&0xFF)<<16)|((rand()&0xFF)<<8)|(rand()&0xFF);
+    }
+    vector<double> l(sz),a(sz),b(sz);
+
+    LabConverter exact(LAB_EXACT);
+    LabConverter fast(LAB_FAST);
+    cout << "exact: " << megapixelsPerSecond(exact,ubuff,l,a,b) << " MP/s" << endl;
+    cout << "fast : " << megapixelsPerSecond(fast,ubuff,l,a,b) << " MP/s" << endl;
+
+    //maximal error of the fast mode over every sRGB color
+    double maxError=0;
+    for(int c=0;c<(1<<24);c++){
+        double l1,a1,b1,l2,a2,b2;
+        exact.convert(c>>16,(c>>8)&0xFF,c&0xFF,l1,a1,b1);
+        fast.convert(c>>16,(c>>8)&0xFF,c&0xFF,l2,a2,b2);
+        maxError=max(maxError,max(fabs(l1-l2),max(fabs(a1-a2),fabs(b1-b2))));
+    }
+    cout << "fast mode maximal L/a/b error: " << maxError << endl;
+
+    return 0;
+}
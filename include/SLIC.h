@@ -19,8 +19,77 @@
 #include <algorithm>
 #include <assert.h>
 #include "pixel.h"
+#include "labconverter.h"
+#include "cpufeatures.h"
+#include "slickernel.h"
 using namespace std;
 
+//============================================================================
+// Storage of the CIELAB image during the SLIC iterations
+//============================================================================
+enum SLICStorageMode
+{
+    SLIC_STORAGE_DOUBLE = 0,//three double planes and a double distance plane
+    SLIC_STORAGE_FLOAT = 1//interleaved single precision L,a,b,distance (LABDPixel)
+};
+
+//============================================================================
+// Buffers of a segmentation. Buffers only grow, so a workspace reused for
+// images of the same or a smaller size does not allocate anymore.
+//============================================================================
+class SLICWorkspace
+{
+public:
+    SLICWorkspace();
+
+    //============================================================================
+    // Labels of the last segmentation run with this workspace
+    //============================================================================
+    const int* GetLabels() const { return klabels.data(); }
+
+    //============================================================================
+    // Packed 0x00RRGGBB input buffer of at least sz pixels, for the caller
+    //============================================================================
+    unsigned int* GetColorBuffer(const int& sz) { return Reserve(colors, sz); }
+
+    //============================================================================
+    // Bytes currently held, and highest value reached since construction
+    //============================================================================
+    size_t GetBytes() const;
+    size_t GetPeakBytes() const { return m_peakbytes; }
+
+    //============================================================================
+    // Free every buffer
+    //============================================================================
+    void Release();
+
+private:
+    friend class SLIC;
+
+    template<class T> T* Reserve(vector<T>& buffer, const int& sz)
+    {
+        if( int(buffer.size()) < sz )
+        {
+            vector<T>().swap(buffer);//no copy of the old content
+            buffer.resize(sz);
+            m_peakbytes = max(m_peakbytes, GetBytes());
+        }
+        return buffer.data();
+    }
+
+    vector<unsigned int>	colors;
+    vector<int>				klabels;
+    vector<int>				nlabels;
+    vector<double>			lvec;
+    vector<double>			avec;
+    vector<double>			bvec;
+    vector<double>			distvec;
+    vector<LABDPixel>		labd;
+    vector<int>				prevlabels;
+    vector<int>				xvec;
+    vector<int>				yvec;
+    size_t					m_peakbytes;
+};
 
 class SLIC  
 {
@@ -37,6 +106,17 @@ public:
                                                          int&						numlabels,
                                                          const int&					superpixelsize, double M);
 
+    //============================================================================
+    // Same segmentation, every buffer taken from workspace. The labels are then
+    // available through workspace.GetLabels() until the next call.
+    //============================================================================
+    void DoSuperpixelSegmentation_ForGivenSuperpixelSize(const unsigned int*                            ubuff,
+                                                         const int					width,
+                                                         const int					height,
+                                                         SLICWorkspace&				workspace,
+                                                         int&						numlabels,
+                                                         const int&					superpixelsize, double M);
+
     //============================================================================
     // sRGB to CIELAB conversion (uses RGB2XYZ function)
     //============================================================================
@@ -48,7 +128,48 @@ public:
             double&						aval,
             double&						bval);
 
+    //============================================================================
+    // Choose between the exact and the table driven CIELAB conversion
+    //============================================================================
+    void SetLABConversionMode(const LabConversionMode&		mode);
+
+    //============================================================================
+    // Number of threads of the SLIC iterations (0: one per core)
+    //============================================================================
+    void SetNumThreads(const int&					numthreads);
+
+    //============================================================================
+    // Precision and layout of the CIELAB image (SLIC_STORAGE_DOUBLE by default)
+    //============================================================================
+    void SetStorageMode(const SLICStorageMode&		mode);
+
+    //============================================================================
+    // Iteration cap and early stopping thresholds (0 disables a threshold)
+    //============================================================================
+    void SetConvergence(const int&					maxiterations,
+                        const double&				mindisplacement,
+                        const double&				minlabelchanges);
+
+    //============================================================================
+    // Number of iterations run by the last segmentation
+    //============================================================================
+    int GetNumIterations() const;
+
+    //============================================================================
+    // Number of workspace bytes per pixel used by the segmentation for a mode
+    //============================================================================
+    static int GetBytesPerPixel(const SLICStorageMode&	mode);
+
 private:
+    //============================================================================
+    // CIELAB color of a pixel, whatever the storage mode
+    //============================================================================
+    inline void GetLAB(const int& i, double& l, double& a, double& b) const
+    {
+        if(m_labd) { l = m_labd[i].l; a = m_labd[i].a; b = m_labd[i].b; }
+        else { l = m_lvec[i]; a = m_avec[i]; b = m_bvec[i]; }
+    }
+
     //============================================================================
     // The main SLIC algorithm for generating superpixels
     //============================================================================
@@ -162,9 +283,24 @@ private:
     double*									m_avec;
     double*									m_bvec;
 
+    LABDPixel*								m_labd;//SLIC_STORAGE_FLOAT replacement of m_lvec, m_avec, m_bvec
+
+    SLICWorkspace*							m_workspace;//owner of the 2-D buffers during a segmentation
+    SLICWorkspace							m_ownworkspace;//used by the klabels allocating interface
+    SLICStorageMode							m_storage;
+
+    int										m_maxiterations;
+    double									m_mindisplacement;//mean seed displacement, in pixels
+    double									m_minlabelchanges;//fraction of pixels
+    int										m_numiterations;
+
     double**								m_lvecvec;
     double**								m_avecvec;
     double**								m_bvecvec;
+
+    LabConverter							m_labconverter;
+    SimdLevel								m_simdlevel;//instruction set of the assignment kernel
+    int										m_numthreads;
 };
 
 #endif // !defined(_SLIC_H_INCLUDED_)
@@ -1,6 +1,7 @@
 #ifndef ASARI_H
 #define ASARI_H
 #include <vector>
+#include <algorithm>
 
 #include "limace.h"
 
@@ -8,49 +9,128 @@
 
 #include "parameters.h"
 #include "ltp.h"
+#include "superpixelstore.h"
+#include "mergetree.h"
 #include <map>
+#include <memory>
 
 using namespace std;
 
+class SLICWorkspace;
+
+/**
+ * @brief Disjoint sets of slic superpixels with path compression and union by size
+ *
+ * Each set is labelled by a region: the superpixel which absorbed the others,
+ * independently of the root chosen to keep trees shallow.
+ */
 class FindUnionAlgo{
 private:
     vector<int> parents;
+    vector<int> sizes;/*!< number of elements of the set of each root */
+    vector<int> regions;/*!< region of the set of each root */
 public:
     void  initialize(int N){
-        parents.clear();
+        parents.resize(N);
+        sizes.assign(N,1);
+        regions.resize(N);
         for(int i=0;i<N;i++){
-            parents.push_back(i);
+            parents[i]=i;
+            regions[i]=i;
         }
     }
 
+    /**
+     * @brief findCC root of the set of x
+     * @param x
+     * @return root
+     */
     int findCC(int x){
-        if(parents[x]==x) return x;
-        else return findCC(parents[x]);
+        int root=x;
+        while(parents[root]!=root) root=parents[root];
+        //compress the path
+        while(parents[x]!=root){
+            int next=parents[x];
+            parents[x]=root;
+            x=next;
+        }
+        return root;
+    }
+
+    /**
+     * @brief findRegion
+     * @param x
+     * @return region of the set of x
+     */
+    int findRegion(int x){
+        return regions[findCC(x)];
     }
 
+    /**
+     * @brief unionCC merge the set of x into the set of y, which keeps its region
+     * @param x
+     * @param y
+     */
     void unionCC(int x,int y){
-        unsigned int xRoot = findCC(x);
-        unsigned int yRoot = findCC(y);
+        int xRoot = findCC(x);
+        int yRoot = findCC(y);
+        if(xRoot==yRoot) return;
+        int region=regions[yRoot];
+        if(sizes[xRoot]>sizes[yRoot]) swap(xRoot,yRoot);
         parents[xRoot] = yRoot;
+        sizes[yRoot]+=sizes[xRoot];
+        regions[yRoot]=region;
     }
 };
 
+/**
+ * @brief ImageDeleter free an image owned by a smart pointer
+ */
+struct ImageDeleter{
+    void operator()(Image image) const{
+        ImFree(&image);
+    }
+};
+
+/**
+ * @brief How Asari gets the image to over-segment
+ */
+enum ImageOwnership{
+    IMAGE_COPY,/*!< Asari works on its own copy */
+    IMAGE_BORROW/*!< Asari works on the caller's image, which must outlive it and its copies */
+};
+
+/**
+ * @brief State of the merging: copies of an Asari share it until one of them changes it
+ */
+struct MergeState{
+    FindUnionAlgo fuAlgo;/*!< slic superpixels merged together */
+    SuperpixelStore superpixelsFeatures;/*!< superpixels indexed by their initial slic label */
+    MergeTree mergeTree;/*!< merges done since the slic over-segmentation */
+    vector<int> finalLabels;/*!< label of each slic superpixel in the over-segmentation */
+    double spRefSize;
+};
+
 /**@@
  * @brief The SlicModified class
+ *
+ * Asari can be moved but not copied: copy() gives an independent over-segmentation which
+ * shares the image, the slic over-segmentation and the merging state, the latter being
+ * copied by the first call to compute or changeParam.
  */
 class Asari
 {
 private:
     //attributs
-    FindUnionAlgo fuAlgo;    
-    Image image;/*!< image to over-segment */
-    Image result;/*!< over-segmentation result */
-    vector<int> superpixelsLabels;
+    shared_ptr<struct sImage> image;/*!< image to over-segment, shared by the copies (not freed when borrowed) */
+    unique_ptr<struct sImage,ImageDeleter> result;/*!< over-segmentation result, drawn by getResult */
+    shared_ptr<const vector<int> > slicLabels;/*!< initial over-segmentation computed by slic */
+    SLICWorkspace* slicWorkspace;/*!< buffers of slic, owned by the caller (NULL: allocated for this image only) */
     int nbSuperpixels;/*!< number of superpixesl */
-    map<int,SuperpixelAsari> superpixelsFeatures;
-    vector<LTP_DATA> ltps;
+    int nbSlicIterations;/*!< number of iterations run by slic */
+    shared_ptr<const SuperpixelStore> initialFeatures;/*!< superpixels before merging, nbHomogeneous is the proportion of homogeneous pixels */
+    shared_ptr<MergeState> state;
     Parameters param;
-    double spRefSize;
     map<int,int> equivalences;
     bool useTexture;
     double meanColorDist;
@@ -64,12 +144,55 @@ private:
      */
     void computeOverSegmentationUsingMerging();
 
+    /**
+     * @brief computeOverSegmentationUsingPriorityQueue merge the most similar pair of adjacent
+     * superpixels first, until no pair fulfills the similarity and regularity criteria or
+     * the target number of superpixels is reached
+     */
+    void computeOverSegmentationUsingPriorityQueue();
+
+    /**
+     * @brief colorDistance distance between average colors
+     * @param sp1
+     * @param sp2
+     * @return distance in [0,1]
+     */
+    double colorDistance(const SuperpixelAsari& sp1, const SuperpixelAsari& sp2) const;
+
+    /**
+     * @brief textureDistance chi2 distance between LTP histograms
+     * @param sp1
+     * @param sp2
+     * @return distance
+     */
+    double textureDistance(const SuperpixelAsari& sp1, const SuperpixelAsari& sp2) const;
+
+    /**
+     * @brief mergingDistance similarity distance of two superpixels (symmetric)
+     * @param idx1
+     * @param idx2
+     * @return color distance for untextured superpixels, color+texture distance for textured ones,
+     * infinity if only one of them is textured
+     */
+    double mergingDistance(int idx1,int idx2) const;
+
     /**
      * @brief mergeSuperpixels
      * @param idx1 index of the main superpixel
      * @param idx2 index of the merged superpixel
+     * @param distance merging distance, recorded in the merge tree
+     */
+    void mergeSuperpixels(int idx1,int idx2,double distance);
+
+    /**
+     * @brief detachState copy the merging state if it is shared with another Asari
+     */
+    void detachState();
+
+    /**
+     * @brief restoreInitialState undo every merge: superpixels are those of slic again
      */
-    void mergeSuperpixels(int idx1,int idx2);
+    void restoreInitialState();
 
     /**
      * @brief updateSpRefSize update superpixel reference size
@@ -88,6 +211,20 @@ private:
      */
     void mergeUsingTexture(int spIdx);
 
+    /**
+     * @brief labelPixels label pixels from the labels of slic superpixels
+     * @param[in] labels label of each slic superpixel
+     * @param[out] pixelsLabels label of each pixel, row by row
+     */
+    void labelPixels(const vector<int>& labels,int* pixelsLabels) const;
+
+    /**
+     * @brief labelPixels
+     * @param labels label of each slic superpixel
+     * @return label of each pixel
+     */
+    vector<int> labelPixels(const vector<int>& labels) const;
+
     /**
      * @brief clearResult
      */
@@ -99,8 +236,31 @@ private:
 
     Asari();
 public:
-    Asari(Parameters& param, Image image,bool useTexture=true);
-    ~Asari();
+    /**
+     * @brief Asari
+     * @param param algorithm parameters
+     * @param image color image to over-segment
+     * @param useTexture use texture information
+     * @param workspace slic buffers to reuse when processing many images of the same size
+     * (NULL: allocated and freed for this image)
+     */
+    Asari(Parameters& param, Image image,bool useTexture=true,SLICWorkspace* workspace=NULL);
+
+    /**
+     * @brief Asari
+     * @param param algorithm parameters
+     * @param image color image to over-segment
+     * @param ownership IMAGE_BORROW to use the image without copying it
+     * @param useTexture use texture information
+     * @param workspace slic buffers to reuse when processing many images of the same size
+     * (NULL: allocated and freed for this image)
+     */
+    Asari(Parameters& param, Image image,ImageOwnership ownership,bool useTexture=true,SLICWorkspace* workspace=NULL);
+
+    Asari(const Asari&)=delete;
+    Asari& operator=(const Asari&)=delete;
+    Asari(Asari&&)=default;
+    Asari& operator=(Asari&&)=default;
 
     /**
      * @brief initializeOversegmntation compute an initial over-segmentation
@@ -118,13 +278,16 @@ public:
      */
     void compute();
     /**
-     * @brief changeParam set parameters
+     * @brief changeParam set parameters, the next call to compute starts from the slic over-segmentation
      * @param param
+     *
+     * Slic and LTP are only computed again when their parameters have changed: a change of the
+     * merging parameters restores the superpixels saved before merging.
      */
     void changeParam(Parameters& param);
     /**
-     * @brief copy copy data
-     * @return
+     * @brief copy copy data, without copying the image and the slic over-segmentation
+     * @return over-segmentation which changes independently of this one
      */
     Asari copy();
     /**
@@ -135,7 +298,55 @@ public:
 
     vector<int> getSuperpixels();
 
+    /**
+     * @brief getSuperpixels write the label of each pixel, without drawing the result image
+     * @param[out] labels buffer of the caller, of width*height labels stored row by row
+     */
+    void getSuperpixels(int* labels) const;
+
+    /**
+     * @brief computeLabels over-segment an image into a label map only: the image is borrowed and
+     * no result image is drawn
+     * @param[in] param algorithm parameters
+     * @param[in] image color image to over-segment
+     * @param[out] labels buffer of the caller, of width*height labels stored row by row
+     * @param[in] useTexture use texture information
+     * @param[in] workspace slic buffers to reuse when processing many images of the same size
+     * (NULL: allocated and freed for this image)
+     * @return number of superpixels
+     */
+    static int computeLabels(Parameters& param, Image image, int* labels, bool useTexture=true, SLICWorkspace* workspace=NULL);
+
+    /**
+     * @brief getMergeTree
+     * @return merges done by compute, from the slic over-segmentation
+     */
+    const MergeTree& getMergeTree() const;
+
+    /**
+     * @brief getSuperpixelsAtNbRegions labels of a finer over-segmentation, without computing it again
+     * @param[in] nbRegions requested number of superpixels, between getNbSp() and the number of slic superpixels
+     * @param[out] nbSp number of superpixels of the over-segmentation
+     * @return label of each pixel
+     */
+    vector<int> getSuperpixelsAtNbRegions(int nbRegions,int& nbSp) const;
+
+    /**
+     * @brief getSuperpixelsAtDistance labels of the over-segmentation given by the first merges
+     * whose distances are lower than or equal to a threshold, see MergeTree
+     * @param[in] distance
+     * @param[out] nbSp number of superpixels of the over-segmentation
+     * @return label of each pixel
+     */
+    vector<int> getSuperpixelsAtDistance(double distance,int& nbSp) const;
+
     int getNbSp();
+
+    /**
+     * @brief getNbSlicIterations
+     * @return number of iterations used by slic for the initial over-segmentation
+     */
+    int getNbSlicIterations();
 };
 
 #endif // SLICMODIFIED_H
@@ -0,0 +1,28 @@
+#ifndef CHI2KERNEL_H
+#define CHI2KERNEL_H
+
+#include "cpufeatures.h"
+
+/**
+ * @brief AccumulateChi2 chi2 distance between two normalised histograms
+ *
+ * For each bin where one of the histograms is not empty, with h1=hist1[i]/nbPixels1 and
+ * h2=hist2[i]/nbPixels2, adds (h1-h2)^2/(h1+h2) to dist and 1 to nbNonZero. Terms are added
+ * in bin order: the vector versions compute the terms with the same IEEE operations as the
+ * scalar one and give bit-identical results. The function is symmetric in its two histograms.
+ *
+ * @param[in] level instruction set to use (must be supported by the CPU)
+ * @param[in] hist1 bin counts of the first histogram
+ * @param[in] nbPixels1 number of samples of the first histogram
+ * @param[in] hist2 bin counts of the second histogram
+ * @param[in] nbPixels2 number of samples of the second histogram
+ * @param[in] nbBins number of bins
+ * @param[in,out] dist distance
+ * @param[in,out] nbNonZero number of non empty bins
+ */
+void AccumulateChi2(SimdLevel level,
+                    const int* hist1, double nbPixels1,
+                    const int* hist2, double nbPixels2,
+                    int nbBins, double& dist, double& nbNonZero);
+
+#endif // CHI2KERNEL_H
@@ -0,0 +1,39 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+/**
+ * @file cpufeatures.h
+ * @brief runtime detection of the x86 vector extensions used by the SIMD kernels
+ *
+ * ASARI_X86_SIMD is defined when the compiler can emit SSE4.1/AVX2 code through
+ * function target attributes, otherwise every kernel falls back to its scalar version.
+ */
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ASARI_X86_SIMD 1
+#endif
+
+/**
+ * @brief vector instruction sets, from the least to the most capable
+ */
+enum SimdLevel{
+    SIMD_SCALAR=0,
+    SIMD_SSE41=1,
+    SIMD_AVX2=2
+};
+
+/**
+ * @brief bestSimdLevel
+ * @return the most capable instruction set supported by the running CPU
+ */
+inline SimdLevel bestSimdLevel(){
+#ifdef ASARI_X86_SIMD
+    static const SimdLevel level = __builtin_cpu_supports("avx2") ? SIMD_AVX2
+                                 : (__builtin_cpu_supports("sse4.1") ? SIMD_SSE41 : SIMD_SCALAR);
+    return level;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+#endif // CPUFEATURES_H
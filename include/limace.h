@@ -176,6 +176,66 @@ extern void ImWriteAsc(Image Im, const char FileName[]);
 extern void ImFree(Image *pIm);
 
 
+/**
+ * @struct PnmMap limace.h
+ * @brief binary pgm (P5) or ppm (P6) file mapped in memory
+ */
+typedef struct sPnmMap *PnmMap;
+
+/**
+ * @brief PnmMapOpen map a binary pgm or ppm file in memory and parse its header
+ *
+ * the pixels are not copied: they are read in place in the mapped file
+ * @param FileName[i] image path
+ * @return the mapped file or NULL if it is not a binary pgm or ppm with maxval <= 255,
+ * or if memory mapping is not available
+ */
+extern PnmMap PnmMapOpen(const char FileName[]);
+
+/**
+ * @brief PnmMapType image type of a mapped file (GrayLevel for P5, Col0r for P6)
+ * @param Map[i] mapped file
+ * @return image type
+ */
+extern ImageType PnmMapType(PnmMap Map);
+
+/**
+ * @brief PnmMapNbRow number of rows of a mapped file
+ * @param Map[i] mapped file
+ * @return number of rows
+ */
+extern int PnmMapNbRow(PnmMap Map);
+
+/**
+ * @brief PnmMapNbCol number of columns of a mapped file
+ * @param Map[i] mapped file
+ * @return number of columns
+ */
+extern int PnmMapNbCol(PnmMap Map);
+
+/**
+ * @brief PnmMapMaxVal maximal value declared in the header of a mapped file
+ * @param Map[i] mapped file
+ * @return maxval
+ */
+extern int PnmMapMaxVal(PnmMap Map);
+
+/**
+ * @brief PnmMapData pixel payload of a mapped file
+ *
+ * row major, one byte per pixel for P5 and interleaved RGB triplets for P6
+ * @param Map[i] mapped file
+ * @return pixels, valid until PnmMapClose
+ */
+extern const unsigned char *PnmMapData(PnmMap Map);
+
+/**
+ * @brief PnmMapClose unmap a file
+ * @param pMap[i] mapped file
+ */
+extern void PnmMapClose(PnmMap *pMap);
+
+
 #ifdef __cplusplus
 }
 #endif
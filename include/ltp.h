@@ -4,6 +4,7 @@
 
 #include "limace.h"
 #include <cmath>
+#include <functional>
 #include <vector>
 
 using namespace std;
@@ -25,6 +26,42 @@ struct LTP_DATA{
     }
 };
 
+/**
+ * @brief LTP of an image packed in two bytes and one bit per pixel
+ */
+struct LTPImage{
+    int width;
+    int height;
+    vector<unsigned char> codesP;/*!< positive code of each pixel */
+    vector<unsigned char> codesN;/*!< negative code of each pixel */
+    vector<unsigned char> homogeneous;/*!< bit plane: bit i%8 of byte i/8 is set if pixel i is homogeneous */
+
+    LTPImage():width(0),height(0){}
+
+    /**
+     * @brief resize set the image size, keeping the allocated memory when it is large enough
+     * @param width
+     * @param height
+     */
+    void resize(int width,int height){
+        this->width=width;
+        this->height=height;
+        codesP.resize(width*height);
+        codesN.resize(width*height);
+        homogeneous.assign((width*height+7)/8,0);
+    }
+
+    bool isHomogeneous(int i) const{
+        return (homogeneous[i>>3]>>(i&7))&1;
+    }
+};
+
+/**
+ * @brief LTPRowConsumer receives the LTP of a row: row index, positive codes, negative codes,
+ * and 0/1 homogeneous flags of the row pixels. Buffers are only valid during the call.
+ */
+typedef function<void(int y,const unsigned char* codesP,const unsigned char* codesN,const unsigned char* homogeneous)> LTPRowConsumer;
+
 /**
  * @brief compute LTP (Local Ternary Pattern) for a given image
  *
@@ -42,7 +79,7 @@ public:
      * @param[in] thresholdLTP threshold to decide if gray scale are similar
      * @param[in] thresholdHomogeneous threshold to decide if LTP is homogenous
      *
-     *  A LTP is homogenous, if a majority of neighbors of the current pixel has similar gray scale
+     *  A LTP is homogenous, if at least thresholdHomogeneous neighbors of the current pixel have similar gray scale
      */
     LTP(int thresholdLTP,int thresholdHomogeneous) : thresholdLTP(thresholdLTP), thresholdHomogeneous(thresholdHomogeneous){};
 
@@ -53,6 +90,25 @@ public:
      */
     vector<LTP_DATA>  computeLTP(Image image);
 
+    /**
+     * @brief computeLTP compute LTP for a given image in a packed buffer
+     * @param[in] image
+     * @param[out] ltps LTP of each pixel, resized to the image size
+     */
+    void computeLTP(Image image,LTPImage& ltps);
+
+    /**
+     * @brief computeLTP compute LTP of rows [y1,y2) and give them row by row to a consumer
+     * @param[in] image
+     * @param[in] y1 first row
+     * @param[in] y2 row after the last one
+     * @param[in] consumer called for each row, in increasing order
+     *
+     * Only three padded grey rows are kept, in a ring buffer: memory does not depend on the
+     * image height. Calls on different row ranges can run concurrently.
+     */
+    void computeLTP(Image image,int y1,int y2,const LTPRowConsumer& consumer) const;
+
 
 
 
@@ -0,0 +1,89 @@
+#ifndef LTPHISTOGRAM_H
+#define LTPHISTOGRAM_H
+
+#include "cpufeatures.h"
+
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Non empty bin of a sparse LTP histogram
+ */
+struct LTPBin{
+    int bin;
+    int count;
+};
+
+/**
+ * @brief Histogram of the 256 LTP codes of a superpixel
+ *
+ * A small superpixel only touches a few codes: the histogram starts as a list of its non
+ * empty bins sorted by code, and switches to 256 dense counts once it has more than
+ * maxSparseBins non empty bins. Counts are the same in both representations, so merging
+ * and distances do not depend on it.
+ */
+class LTPHistogram
+{
+private:
+    vector<int> dense;/*!< counts of the 256 codes, empty while the histogram is sparse */
+    vector<LTPBin> sparse;/*!< non empty bins sorted by code, while the histogram is sparse */
+
+    /**
+     * @brief toDense switch to the dense representation
+     */
+    void toDense();
+public:
+    static const int nbBins=256;
+    static const int maxSparseBins=64;/*!< a sparse histogram takes half the size of a dense one */
+
+    LTPHistogram(){}
+
+    bool isDense() const {return !dense.empty();}
+
+    /**
+     * @brief add add samples to a bin
+     * @param[in] bin LTP code in [0,255]
+     * @param[in] count number of samples
+     */
+    void add(int bin,int count=1);
+
+    /**
+     * @brief merge add the counts of another histogram
+     * @param[in] other
+     */
+    void merge(const LTPHistogram& other);
+
+    /**
+     * @brief count
+     * @param[in] bin LTP code in [0,255]
+     * @return number of samples of the bin
+     */
+    int count(int bin) const;
+
+    /**
+     * @brief clear remove every sample and release memory
+     */
+    void clear();
+
+    /**
+     * @brief accumulateChi2 chi2 distance between two normalised histograms, see AccumulateChi2
+     *
+     * Dense histograms go through the vector kernel; otherwise the non empty bins are visited
+     * in code order with the same operations, so the result does not depend on the representations.
+     *
+     * @param[in] level instruction set to use (must be supported by the CPU)
+     * @param[in] hist1 first histogram
+     * @param[in] nbPixels1 number of samples of the first histogram
+     * @param[in] hist2 second histogram
+     * @param[in] nbPixels2 number of samples of the second histogram
+     * @param[in,out] dist distance
+     * @param[in,out] nbNonZero number of non empty bins
+     */
+    static void accumulateChi2(SimdLevel level,
+                               const LTPHistogram& hist1, double nbPixels1,
+                               const LTPHistogram& hist2, double nbPixels2,
+                               double& dist, double& nbNonZero);
+};
+
+#endif // LTPHISTOGRAM_H
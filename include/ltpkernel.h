@@ -0,0 +1,31 @@
+#ifndef LTPKERNEL_H
+#define LTPKERNEL_H
+
+#include "cpufeatures.h"
+
+/**
+ * @brief ComputeLTPRow local ternary patterns of a row of grey levels
+ *
+ * Rows are padded with one pixel on each side: pixel x of the row is at index x+1. Each pixel
+ * is compared with its 8 neighbours, bit 0 for north then clockwise up to bit 7 for north-west.
+ * A neighbour is similar when the absolute difference is lower than threshold; otherwise the
+ * bit is set in codesP if the pixel is greater than or equal to it, in codesN if it is lower.
+ * As in the original LTP implementation, the north-east neighbour never sets a bit of codesN.
+ * The vector versions give the same bytes as the scalar one.
+ *
+ * @param[in] level instruction set to use (must be supported by the CPU)
+ * @param[in] above padded row above
+ * @param[in] row padded row
+ * @param[in] below padded row below
+ * @param[in] width number of pixels of the row (without padding)
+ * @param[in] threshold similarity threshold in [0,255]
+ * @param[out] codesP positive codes of the width pixels
+ * @param[out] codesN negative codes of the width pixels
+ * @param[out] similar masks of the similar neighbours of the width pixels
+ */
+void ComputeLTPRow(SimdLevel level,
+                   const unsigned char* above, const unsigned char* row, const unsigned char* below,
+                   int width, int threshold,
+                   unsigned char* codesP, unsigned char* codesN, unsigned char* similar);
+
+#endif // LTPKERNEL_H
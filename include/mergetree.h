@@ -0,0 +1,78 @@
+#ifndef MERGETREE_H
+#define MERGETREE_H
+
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Merge of two superpixels: the absorbed one joins the absorbing one, which keeps its label
+ */
+struct MergeEvent{
+    int absorbing;
+    int absorbed;
+    double distance;/*!< merging distance of the two superpixels */
+    double height;/*!< largest distance of the merges up to this one */
+};
+
+/**
+ * @brief Merge tree (dendrogram) of the slic superpixels
+ *
+ * Merges are recorded in the order they are done. Keeping the first merges of the tree gives
+ * every intermediate over-segmentation, from the slic superpixels to the final result.
+ * Merge distances are not monotonic, so a distance cut uses the height of the merges: it keeps
+ * the longest sequence of first merges whose distances are all below the threshold.
+ */
+class MergeTree
+{
+private:
+    int nbLeaves;
+    vector<MergeEvent> merges;
+public:
+    MergeTree():nbLeaves(0){}
+
+    /**
+     * @brief initialize remove every merge
+     * @param nbLeaves number of slic superpixels
+     */
+    void initialize(int nbLeaves);
+
+    /**
+     * @brief record add a merge after the previous ones
+     * @param absorbing
+     * @param absorbed
+     * @param distance
+     */
+    void record(int absorbing,int absorbed,double distance);
+
+    int getNbLeaves() const {return nbLeaves;}
+    int getNbMerges() const {return merges.size();}
+    const MergeEvent& operator[](int i) const {return merges[i];}
+
+    /**
+     * @brief cut over-segmentation obtained after the first merges, in O(nbLeaves+nbMerges)
+     * @param[in] nbMerges number of merges to keep, in [0,getNbMerges()]
+     * @param[out] labels label of each slic superpixel: regions are numbered in ascending order
+     * of the superpixel which absorbed the others, as Asari::compute numbers them
+     * @return number of regions
+     */
+    int cut(int nbMerges,vector<int>& labels) const;
+
+    /**
+     * @brief cutAtNbRegions
+     * @param[in] nbRegions requested number of regions, clamped to the over-segmentations of the tree
+     * @param[out] labels label of each slic superpixel
+     * @return number of regions
+     */
+    int cutAtNbRegions(int nbRegions,vector<int>& labels) const;
+
+    /**
+     * @brief cutAtDistance keep the first merges whose distances are all lower than or equal to a threshold
+     * @param[in] distance threshold
+     * @param[out] labels label of each slic superpixel
+     * @return number of regions
+     */
+    int cutAtDistance(double distance,vector<int>& labels) const;
+};
+
+#endif // MERGETREE_H
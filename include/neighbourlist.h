@@ -0,0 +1,92 @@
+#ifndef NEIGHBOURLIST_H
+#define NEIGHBOURLIST_H
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Labels of the superpixels adjacent to a superpixel
+ *
+ * Labels are kept sorted in a contiguous array: iteration visits them in ascending order,
+ * as a set<int> would, without a tree node per neighbour.
+ */
+class NeighbourList
+{
+private:
+    vector<int> labels;
+public:
+    typedef vector<int>::const_iterator const_iterator;
+
+    const_iterator begin() const {return labels.begin();}
+    const_iterator end() const {return labels.end();}
+    int size() const {return labels.size();}
+
+    /**
+     * @brief upper_bound
+     * @param idx
+     * @return first neighbour greater than idx
+     */
+    const_iterator upper_bound(int idx) const{
+        return std::upper_bound(labels.begin(),labels.end(),idx);
+    }
+
+    bool contains(int idx) const{
+        return binary_search(labels.begin(),labels.end(),idx);
+    }
+
+    /**
+     * @brief insert add a neighbour if it is not already in the list
+     * @param idx
+     */
+    void insert(int idx){
+        vector<int>::iterator it=lower_bound(labels.begin(),labels.end(),idx);
+        if(it==labels.end() || *it!=idx) labels.insert(it,idx);
+    }
+
+    /**
+     * @brief erase remove a neighbour if it is in the list
+     * @param idx
+     */
+    void erase(int idx){
+        vector<int>::iterator it=lower_bound(labels.begin(),labels.end(),idx);
+        if(it!=labels.end() && *it==idx) labels.erase(it);
+    }
+
+    /**
+     * @brief unite add the neighbours of another list
+     * @param other
+     */
+    void unite(const NeighbourList& other){
+        vector<int> merged;
+        merged.reserve(labels.size()+other.labels.size());
+        set_union(labels.begin(),labels.end(),other.labels.begin(),other.labels.end(),back_inserter(merged));
+        labels.swap(merged);
+    }
+
+    /**
+     * @brief append add a neighbour without keeping the list sorted, see sortUnique
+     * @param idx
+     */
+    void append(int idx){
+        if(labels.empty() || labels.back()!=idx) labels.push_back(idx);
+    }
+
+    /**
+     * @brief sortUnique sort the list and remove duplicates after a sequence of append
+     */
+    void sortUnique(){
+        sort(labels.begin(),labels.end());
+        labels.erase(unique(labels.begin(),labels.end()),labels.end());
+    }
+
+    /**
+     * @brief clear remove every neighbour and release memory
+     */
+    void clear(){
+        vector<int>().swap(labels);
+    }
+};
+
+#endif // NEIGHBOURLIST_H
@@ -0,0 +1,49 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief resolveNbThreads
+ * @param nbThreads requested number of threads, 0 for one thread per core
+ * @return number of threads to use (at least 1)
+ */
+inline int resolveNbThreads(int nbThreads){
+    if(nbThreads>0) return nbThreads;
+    unsigned int nbCores=std::thread::hardware_concurrency();
+    return nbCores>0 ? int(nbCores) : 1;
+}
+
+/**
+ * @brief parallelFor run task(0)...task(nbTasks-1) on nbThreads threads
+ *
+ * Tasks are handed out dynamically, so a task must only write data it owns: the result
+ * must not depend on which thread runs which task. The calling thread takes part in the
+ * work and the function returns once every task is done.
+ *
+ * @param nbThreads number of threads, 0 for one thread per core
+ * @param nbTasks number of tasks
+ * @param task callable taking the task index
+ */
+template<class Task>
+void parallelFor(int nbThreads, int nbTasks, const Task& task){
+    nbThreads=std::min(resolveNbThreads(nbThreads),nbTasks);
+    if(nbThreads<=1){
+        for(int t=0;t<nbTasks;t++) task(t);
+        return;
+    }
+
+    std::atomic<int> next(0);
+    auto worker=[&](){
+        for(int t=next++;t<nbTasks;t=next++) task(t);
+    };
+    std::vector<std::thread> workers;
+    for(int i=1;i<nbThreads;i++) workers.push_back(std::thread(worker));
+    worker();
+    for(unsigned int i=0;i<workers.size();i++) workers[i].join();
+}
+
+#endif // PARALLEL_H
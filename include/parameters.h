@@ -9,6 +9,9 @@
 #include <string>
 #include <fstream>
 
+#include "ltphistogram.h"
+#include "neighbourlist.h"
+
 using namespace std;
 
 class Point{
@@ -35,6 +38,14 @@ struct Parameters{
     double slicSpSizeFactor=0.00015;/*!< average superpixel size for slic algorithm is slicSpSizeFactor*nbPixels */
     double minSizeFactor=60;/*! slic superpixels minimum size factor: average size computed with slicSpSizeFactor must be greather than or equals to minSizeFactor */
     double slicCompacity=10;/*!< slic compacity paramert */
+    bool slicFastLab=false;/*!< slic uses the table driven CIELAB conversion (bounded error, see LabConverter) */
+    bool slicSinglePrecision=false;/*!< slic iterates on interleaved float LAB pixels (see SLIC::GetBytesPerPixel) */
+    int slicMaxIterations=3;/*!< maximal number of slic iterations */
+    double slicMinSeedDisplacement=0;/*!< slic stops when the mean seed displacement (pixels) is lower, 0 to disable */
+    double slicMinLabelChanges=0;/*!< slic stops when the fraction of pixels changing label is lower, 0 to disable */
+    int nbThreads=0;/*!< number of threads, 0 to use one thread per core (results do not depend on it) */
+    bool mergeWithPriorityQueue=false;/*!< merge the most similar pair of superpixels first instead of sweeping them in label order */
+    int targetNbSuperpixels=0;/*!< priority queue merging stops at this number of superpixels, 0 to disable */
 
     /**
      * @brief Parameters default constructor :  check if parameters are consistent
@@ -48,8 +59,31 @@ struct Parameters{
         assert(spUnTexturedThreshold>=0 && spUnTexturedThreshold<=1);
         assert(slicSpSizeFactor>=0 && slicSpSizeFactor<=1);
         assert(similarityThreshold>=0 && similarityThreshold<=1);
+        assert(slicMaxIterations>=1);
+        assert(targetNbSuperpixels>=0);
+
 
+    }
 
+    /**
+     * @brief sameSlic
+     * @param other
+     * @return true if other gives the same slic over-segmentation
+     */
+    bool sameSlic(const Parameters& other) const{
+        return slicSpSizeFactor==other.slicSpSizeFactor && minSizeFactor==other.minSizeFactor
+                && slicCompacity==other.slicCompacity && slicFastLab==other.slicFastLab
+                && slicSinglePrecision==other.slicSinglePrecision && slicMaxIterations==other.slicMaxIterations
+                && slicMinSeedDisplacement==other.slicMinSeedDisplacement && slicMinLabelChanges==other.slicMinLabelChanges;
+    }
+
+    /**
+     * @brief sameLtp
+     * @param other
+     * @return true if other gives the same LTP
+     */
+    bool sameLtp(const Parameters& other) const{
+        return ltpThr==other.ltpThr && ltpUniThr==other.ltpUniThr;
     }
 
     void print(){
@@ -58,6 +92,14 @@ struct Parameters{
         cout << "texture detection threshold : " << spUnTexturedThreshold << endl;
         cout << "slic superpixel size factor : " << slicSpSizeFactor << endl;
         cout << "slic compacity parameter: " << slicCompacity << endl;
+        cout << "slic fast lab conversion: " << slicFastLab << endl;
+        cout << "slic single precision: " << slicSinglePrecision << endl;
+        cout << "slic maximal iterations: " << slicMaxIterations << endl;
+        cout << "slic minimal seed displacement: " << slicMinSeedDisplacement << endl;
+        cout << "slic minimal label changes: " << slicMinLabelChanges << endl;
+        cout << "number of threads: " << nbThreads << endl;
+        cout << "priority queue merging: " << mergeWithPriorityQueue << endl;
+        cout << "target number of superpixels: " << targetNbSuperpixels << endl;
         cout << "similarity threshold : " << similarityThreshold << endl;
         cout << "regularity parameter : " << regularityParam << endl;
         cout << "minimal size: " << minSizeFactor << endl;
@@ -71,16 +113,13 @@ public:
     double red;
     double green;
     double blue;
-    std::vector<int> ltpHistN;
-    std::vector<int> ltpHistP;
-    vector<Point> pixelsCoordinates;
+    LTPHistogram ltpHistN;
+    LTPHistogram ltpHistP;
     double nbPixels;
-    std::set<int> neighboors;
+    NeighbourList neighboors;
     double nbHomogeneous;
     bool homogeneous;
     SuperpixelAsari():red(0),green(0),blue(0),nbPixels(0),homogeneous(true){
-        ltpHistN.assign(256,0);
-        ltpHistP.assign(256,0);
         nbHomogeneous=0;
 
     }
@@ -0,0 +1,67 @@
+#ifndef SLICKERNEL_H
+#define SLICKERNEL_H
+
+#include "cpufeatures.h"
+
+/**
+ * @brief Seed of a SLIC cluster in the LAB+XY space
+ */
+struct SLICSeed{
+    double l;
+    double a;
+    double b;
+    double x;
+    double y;
+};
+
+/**
+ * @brief Single precision pixel of the SLIC float storage mode
+ *
+ * The LAB color and the distance to the closest seed are interleaved in 16 bytes, so the
+ * assignment step reads and writes one cache line for four pixels.
+ */
+struct LABDPixel{
+    float l;
+    float a;
+    float b;
+    float dist;
+};
+
+/**
+ * @brief AssignRowSegment SLIC assignment step on the pixels [x1,x2) of row y
+ *
+ * For each pixel, computes the LAB distance plus the XY distance weighted by invwt
+ * to the seed and, if it is strictly lower than distvec, stores it and sets the
+ * pixel label to label. The vector versions perform the same floating point
+ * operations in the same order as the scalar one, so results are bit-identical.
+ *
+ * @param[in] level instruction set to use (must be supported by the CPU)
+ * @param[in] lvec,avec,bvec LAB planes of the image
+ * @param[in,out] distvec distance of each pixel to its closest seed
+ * @param[in,out] klabels label of each pixel
+ * @param[in] width image width
+ * @param[in] y row
+ * @param[in] x1 first column
+ * @param[in] x2 column after the last one
+ * @param[in] seed cluster seed
+ * @param[in] invwt weight of the XY distance
+ * @param[in] label label of the seed
+ */
+void AssignRowSegment(SimdLevel level,
+                      const double* lvec, const double* avec, const double* bvec,
+                      double* distvec, int* klabels,
+                      int width, int y, int x1, int x2,
+                      const SLICSeed& seed, double invwt, int label);
+
+/**
+ * @brief AssignRowSegment single precision version working on interleaved LAB+dist pixels
+ *
+ * Distances are computed in float; the vector version matches the scalar one bit for bit.
+ * AVX2 CPUs use the SSE4.1 version.
+ */
+void AssignRowSegment(SimdLevel level,
+                      LABDPixel* pixels, int* klabels,
+                      int width, int y, int x1, int x2,
+                      const SLICSeed& seed, double invwt, int label);
+
+#endif // SLICKERNEL_H
@@ -0,0 +1,121 @@
+#ifndef SUPERPIXELSTORE_H
+#define SUPERPIXELSTORE_H
+
+#include "parameters.h"
+
+#include <assert.h>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Dense container of the superpixels being merged
+ *
+ * Superpixels are addressed by their initial slic label, so a lookup is a vector access.
+ * A merged superpixel leaves a tombstone; the live ones are chained in ascending label
+ * order, which is the iteration order of the former map<int,SuperpixelAsari>: removing
+ * a superpixel other than the current one does not disturb an ongoing iteration.
+ */
+class SuperpixelStore
+{
+private:
+    vector<SuperpixelAsari> superpixels;
+    vector<int> nextLive;/*!< next live label, -1 at the end */
+    vector<int> prevLive;/*!< previous live label, -1 at the beginning */
+    int firstLive;
+    int nbLive;
+public:
+    SuperpixelStore():firstLive(-1),nbLive(0){}
+
+    /**
+     * @brief initialize create nbSuperpixels empty superpixels labelled 0 to nbSuperpixels-1
+     * @param nbSuperpixels
+     */
+    void initialize(int nbSuperpixels){
+        superpixels.assign(nbSuperpixels,SuperpixelAsari());
+        nextLive.resize(nbSuperpixels);
+        prevLive.resize(nbSuperpixels);
+        for(int i=0;i<nbSuperpixels;i++){
+            nextLive[i]=i+1<nbSuperpixels ? i+1 : -1;
+            prevLive[i]=i-1;
+        }
+        firstLive=nbSuperpixels>0 ? 0 : -1;
+        nbLive=nbSuperpixels;
+    }
+
+    void clear(){
+        initialize(0);
+    }
+
+    SuperpixelAsari& operator[](int idx){
+        assert(isAlive(idx));
+        return superpixels[idx];
+    }
+
+    const SuperpixelAsari& operator[](int idx) const{
+        assert(isAlive(idx));
+        return superpixels[idx];
+    }
+
+    /**
+     * @brief isAlive
+     * @param idx superpixel label
+     * @return false if the superpixel has been merged into another one
+     */
+    bool isAlive(int idx) const{
+        return idx>=0 && idx<int(superpixels.size()) && (prevLive[idx]>=0 || firstLive==idx);
+    }
+
+    /**
+     * @brief erase remove a superpixel and release its memory
+     * @param idx superpixel label
+     */
+    void erase(int idx){
+        assert(isAlive(idx));
+        if(prevLive[idx]>=0) nextLive[prevLive[idx]]=nextLive[idx];
+        else firstLive=nextLive[idx];
+        if(nextLive[idx]>=0) prevLive[nextLive[idx]]=prevLive[idx];
+        prevLive[idx]=-1;
+        nextLive[idx]=-1;
+        SuperpixelAsari& sp=superpixels[idx];
+        sp.ltpHistN.clear();
+        sp.ltpHistP.clear();
+        sp.neighboors.clear();
+        nbLive--;
+    }
+
+    /**
+     * @brief size
+     * @return number of live superpixels
+     */
+    int size() const{
+        return nbLive;
+    }
+
+    /**
+     * @brief capacity
+     * @return number of initial superpixels (live or not)
+     */
+    int capacity() const{
+        return superpixels.size();
+    }
+
+    /**
+     * @brief first
+     * @return lowest live label, -1 if the store is empty
+     */
+    int first() const{
+        return firstLive;
+    }
+
+    /**
+     * @brief next
+     * @param idx live superpixel label
+     * @return next live label in ascending order, -1 after the last one
+     */
+    int next(int idx) const{
+        return nextLive[idx];
+    }
+};
+
+#endif // SUPERPIXELSTORE_H
@@ -0,0 +1,43 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "limace.h"
+#include "parameters.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Result of one configuration of a parameter sweep
+ */
+struct SweepResult{
+    Parameters param;
+    int group;/*!< configurations of a group share slic, LTP and initial features */
+    int nbSuperpixels;
+    vector<int> labels;/*!< label of each pixel */
+    double initializationTime;/*!< seconds spent in slic, LTP and initial features by the group */
+    double mergingTime;/*!< seconds spent merging superpixels for this configuration */
+};
+
+/**
+ * @brief sweepParameters over-segment an image with many configurations
+ *
+ * Configurations with the same slic and LTP parameters (see Parameters::sameSlic and
+ * Parameters::sameLtp) form a group: slic, LTP and the initial features are computed once
+ * per group, then the merging of its configurations is spread over threads, each one
+ * restarting from the initial superpixels. Results are those of a separate Asari per
+ * configuration, in the order of the configurations.
+ *
+ * @param[in] image color image
+ * @param[in] configurations
+ * @param[in] useTexture use texture information
+ * @param[in] nbThreads number of threads merging configurations, 0 for one thread per core
+ * @param[in] resPrefix if not empty, the boundaries of configuration i are written in resPrefix followed by i and ".ppm"
+ * @return results of the configurations
+ */
+vector<SweepResult> sweepParameters(Image image, const vector<Parameters>& configurations, bool useTexture=true,
+                                    int nbThreads=0, const string& resPrefix="");
+
+#endif // SWEEP_H
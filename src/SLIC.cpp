@@ -9,29 +9,66 @@
 #include <iostream>
 #include <fstream>
 #include "SLIC.h"
+#include "slickernel.h"
+#include "parallel.h"
 
 
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
 
+SLICWorkspace::SLICWorkspace()
+{
+    m_peakbytes = 0;
+}
+
+size_t SLICWorkspace::GetBytes() const
+{
+    return colors.size()*sizeof(unsigned int) +
+           (klabels.size() + nlabels.size() + prevlabels.size() + xvec.size() + yvec.size())*sizeof(int) +
+           (lvec.size() + avec.size() + bvec.size() + distvec.size())*sizeof(double) +
+           labd.size()*sizeof(LABDPixel);
+}
+
+void SLICWorkspace::Release()
+{
+    vector<unsigned int>().swap(colors);
+    vector<int>().swap(klabels);
+    vector<int>().swap(nlabels);
+    vector<double>().swap(lvec);
+    vector<double>().swap(avec);
+    vector<double>().swap(bvec);
+    vector<double>().swap(distvec);
+    vector<LABDPixel>().swap(labd);
+    vector<int>().swap(prevlabels);
+    vector<int>().swap(xvec);
+    vector<int>().swap(yvec);
+}
+
 SLIC::SLIC()
 {
     m_lvec = NULL;
     m_avec = NULL;
     m_bvec = NULL;
+    m_labd = NULL;
+    m_workspace = &m_ownworkspace;
+    m_storage = SLIC_STORAGE_DOUBLE;
 
 	m_lvecvec = NULL;
 	m_avecvec = NULL;
 	m_bvecvec = NULL;
+
+    m_simdlevel = bestSimdLevel();
+    m_numthreads = 0;
+
+    m_maxiterations = 3;
+    m_mindisplacement = 0;
+    m_minlabelchanges = 0;
+    m_numiterations = 0;
 }
 
 SLIC::~SLIC()
 {
-    if(m_lvec) delete [] m_lvec;
-    if(m_avec) delete [] m_avec;
-    if(m_bvec) delete [] m_bvec;
-
 
 	if(m_lvecvec)
 	{
@@ -86,37 +123,79 @@ void SLIC::RGB2XYZ(
 //===========================================================================
 void SLIC::RGB2LAB(const int& sR, const int& sG, const int& sB, double& lval, double& aval, double& bval)
 {
-	//------------------------
-	// sRGB to XYZ conversion
-	//------------------------
-	double X, Y, Z;
-	RGB2XYZ(sR, sG, sB, X, Y, Z);
-
-	//------------------------
-	// XYZ to LAB conversion
-	//------------------------
-	double epsilon = 0.008856;	//actual CIE standard
-	double kappa   = 903.3;		//actual CIE standard
-
-	double Xr = 0.950456;	//reference white
-	double Yr = 1.0;		//reference white
-	double Zr = 1.088754;	//reference white
-
-	double xr = X/Xr;
-	double yr = Y/Yr;
-	double zr = Z/Zr;
-
-	double fx, fy, fz;
-	if(xr > epsilon)	fx = pow(xr, 1.0/3.0);
-	else				fx = (kappa*xr + 16.0)/116.0;
-	if(yr > epsilon)	fy = pow(yr, 1.0/3.0);
-	else				fy = (kappa*yr + 16.0)/116.0;
-	if(zr > epsilon)	fz = pow(zr, 1.0/3.0);
-	else				fz = (kappa*zr + 16.0)/116.0;
-
-	lval = 116.0*fy-16.0;
-	aval = 500.0*(fx-fy);
-	bval = 200.0*(fy-fz);
+	m_labconverter.convert(sR, sG, sB, lval, aval, bval);
+}
+
+//===========================================================================
+///	SetLABConversionMode
+///
+/// LAB_EXACT reproduces RGB2XYZ/pow() results, LAB_FAST trades a bounded
+/// error (see labconverter.h) for the pow(x,1/3) calls.
+//===========================================================================
+void SLIC::SetLABConversionMode(const LabConversionMode& mode)
+{
+	m_labconverter = LabConverter(mode);
+}
+
+//===========================================================================
+///	SetNumThreads
+///
+/// 0 uses one thread per core. The segmentation does not depend on it.
+//===========================================================================
+void SLIC::SetNumThreads(const int& numthreads)
+{
+	m_numthreads = numthreads;
+}
+
+//===========================================================================
+///	SetConvergence
+///
+/// At most maxiterations iterations are run (3 by default). The iterations
+/// also stop as soon as the mean seed displacement (in pixels) is lower than
+/// mindisplacement, or the fraction of pixels whose label changed is lower
+/// than minlabelchanges. A threshold of 0 disables the matching test.
+//===========================================================================
+void SLIC::SetConvergence(const int& maxiterations, const double& mindisplacement, const double& minlabelchanges)
+{
+	m_maxiterations = maxiterations;
+	m_mindisplacement = mindisplacement;
+	m_minlabelchanges = minlabelchanges;
+}
+
+//===========================================================================
+///	GetNumIterations
+//===========================================================================
+int SLIC::GetNumIterations() const
+{
+	return m_numiterations;
+}
+
+//===========================================================================
+///	SetStorageMode
+///
+/// SLIC_STORAGE_FLOAT runs the iterations in single precision on interleaved
+/// pixels. Seed perturbation (DetectLabEdges) needs SLIC_STORAGE_DOUBLE.
+//===========================================================================
+void SLIC::SetStorageMode(const SLICStorageMode& mode)
+{
+	m_storage = mode;
+}
+
+//===========================================================================
+///	GetBytesPerPixel
+///
+/// Bytes reserved per pixel in the SLICWorkspace by a segmentation: CIELAB
+/// image, distance, klabels, nlabels and the xvec/yvec search buffers.
+///		SLIC_STORAGE_DOUBLE: 24 + 8 + 4 + 4 + 8 = 48 bytes
+///		SLIC_STORAGE_FLOAT:  16 + 4 + 4 + 8     = 32 bytes (distance in LABDPixel)
+/// A label change threshold (SetConvergence) adds 4 bytes. During the
+/// iterations the working set is 36 bytes (3 doubles, distance, label)
+/// against 20 bytes (one LABDPixel, label).
+//===========================================================================
+int SLIC::GetBytesPerPixel(const SLICStorageMode& mode)
+{
+	int labdist = (mode == SLIC_STORAGE_FLOAT) ? sizeof(LABDPixel) : 4*sizeof(double);
+	return labdist + 2*sizeof(int) + 2*sizeof(int);
 }
 
 //===========================================================================
@@ -131,18 +210,11 @@ void SLIC::DoRGBtoLABConversion(
     double*&					bvec)
 {
 	int sz = m_width*m_height;
-    lvec = new double[sz];
-    avec = new double[sz];
-    bvec = new double[sz];
+    lvec = m_workspace->Reserve(m_workspace->lvec, sz);
+    avec = m_workspace->Reserve(m_workspace->avec, sz);
+    bvec = m_workspace->Reserve(m_workspace->bvec, sz);
 
-	for( int j = 0; j < sz; j++ )
-	{
-		int r = (ubuff[j] >> 16) & 0xFF;
-		int g = (ubuff[j] >>  8) & 0xFF;
-		int b = (ubuff[j]      ) & 0xFF;
-
-        RGB2LAB( r, g, b, lvec[j], avec[j], bvec[j] );
-	}
+    m_labconverter.convert(ubuff, sz, lvec, avec, bvec);
 }
 
 //===========================================================================
@@ -159,14 +231,7 @@ void SLIC::DoRGBtoLABConversion(
     int sz = m_width*m_height;
     for( int d = 0; d < m_depth; d++ )
     {
-        for( int j = 0; j < sz; j++ )
-        {
-            int r = (ubuff[d][j] >> 16) & 0xFF;
-            int g = (ubuff[d][j] >>  8) & 0xFF;
-            int b = (ubuff[d][j]      ) & 0xFF;
-
-            RGB2LAB( r, g, b, lvec[d][j], avec[d][j], bvec[d][j] );
-        }
+        m_labconverter.convert(ubuff[d], sz, lvec[d], avec[d], bvec[d]);
     }
 }
 
@@ -245,9 +310,7 @@ void SLIC::PerturbSeeds(
 		{
 			kseedsx[n] = storeind%m_width;
 			kseedsy[n] = storeind/m_width;
-			kseedsl[n] = m_lvec[storeind];
-			kseedsa[n] = m_avec[storeind];
-			kseedsb[n] = m_bvec[storeind];
+			GetLAB(storeind, kseedsl[n], kseedsa[n], kseedsb[n]);
 		}
 	}
 }
@@ -305,9 +368,7 @@ void SLIC::GetLABXYSeeds_ForGivenStepSize(
             int seedy = (y*STEP+yoff+ye);
             int i = seedy*m_width + seedx;
 			
-			kseedsl[n] = m_lvec[i];
-			kseedsa[n] = m_avec[i];
-			kseedsb[n] = m_bvec[i];
+			GetLAB(i, kseedsl[n], kseedsa[n], kseedsb[n]);
             kseedsx[n] = seedx;
             kseedsy[n] = seedy;
 			n++;
@@ -418,85 +479,121 @@ void SLIC::PerformSuperpixelSLIC(vector<double>&				kseedsl,
         vector<double> sigmab(numk, 0);
         vector<double> sigmax(numk, 0);
         vector<double> sigmay(numk, 0);
-        vector<double> distvec(sz, DBL_MAX);
+        double* distvec = m_labd ? NULL : m_workspace->Reserve(m_workspace->distvec, sz);//SLIC_STORAGE_FLOAT keeps it in m_labd
 
         double invwt = 1.0/((STEP/M)*(STEP/M));
 
-        int x1, y1, x2, y2;
-        double l, a, b;
-        double dist;
-        double distxy;
-        for( int itr = 0; itr < 3; itr++ )
+        //------------------------------------------------------------------------
+        // The assignment splits the rows in bands updated in parallel: a band only
+        // writes its own pixels and visits the seeds in the same order as the serial
+        // loop, so the labels do not depend on the number of threads.
+        //------------------------------------------------------------------------
+        const int numbands = min(m_height, 4*resolveNbThreads(m_numthreads));
+        vector<int> bx1(numk), by1(numk), bx2(numk), by2(numk);//search window, then bounding box, of each seed
+        vector< vector<int> > orphans(numbands);//pixels reached by no window keep their previous label
+        int* prevlabels = m_minlabelchanges > 0 ? m_workspace->Reserve(m_workspace->prevlabels, sz) : NULL;
+        vector<long> labelchanges(numbands, 0);
+        vector<double> prevx(numk), prevy(numk);
+
+        m_numiterations = 0;
+        for( int itr = 0; itr < m_maxiterations; itr++ )
         {
-            distvec.assign(sz, DBL_MAX);
             for( int n = 0; n < numk; n++ )
             {
-                            y1 = max(0.0,			kseedsy[n]-offset);
-                            y2 = min((double)m_height,	kseedsy[n]+offset);
-                            x1 = max(0.0,			kseedsx[n]-offset);
-                            x2 = min((double)m_width,	kseedsx[n]+offset);
-
+                            by1[n] = max(0.0,			kseedsy[n]-offset);
+                            by2[n] = min((double)m_height,	kseedsy[n]+offset);
+                            bx1[n] = max(0.0,			kseedsx[n]-offset);
+                            bx2[n] = min((double)m_width,	kseedsx[n]+offset);
+            }
 
-                for( int y = y1; y < y2; y++ )
+            parallelFor(m_numthreads, numbands, [&](int band)
+            {
+                const int r1 = band*m_height/numbands;
+                const int r2 = (band+1)*m_height/numbands;
+                if( prevlabels ) copy(klabels+r1*m_width, klabels+r2*m_width, prevlabels+r1*m_width);
+                if( m_labd ) { for( int i = r1*m_width; i < r2*m_width; i++ ) m_labd[i].dist = FLT_MAX; }
+                else fill(distvec+r1*m_width, distvec+r2*m_width, DBL_MAX);
+                for( int n = 0; n < numk; n++ )
                 {
-                    for( int x = x1; x < x2; x++ )
-                    {
-                        int i = y*m_width + x;
+                    const int y1 = max(by1[n], r1);
+                    const int y2 = min(by2[n], r2);
+                    if( y1 >= y2 ) continue;
 
-                        l = m_lvec[i];
-                        a = m_avec[i];
-                        b = m_bvec[i];
+                    const SLICSeed seed = {kseedsl[n], kseedsa[n], kseedsb[n], kseedsx[n], kseedsy[n]};
 
-                        dist =			(l - kseedsl[n])*(l - kseedsl[n]) +
-                                        (a - kseedsa[n])*(a - kseedsa[n]) +
-                                        (b - kseedsb[n])*(b - kseedsb[n]);
-
-                        distxy =		(x - kseedsx[n])*(x - kseedsx[n]) +
-                                        (y - kseedsy[n])*(y - kseedsy[n]);
-
-                        //------------------------------------------------------------------------
-                        dist += distxy*invwt;//dist = sqrt(dist) + sqrt(distxy*invwt);//this is more exact
-                        //------------------------------------------------------------------------
-                        if( dist < distvec[i] )
-                        {
-                            distvec[i] = dist;
-                            klabels[i]  = n;
-                        }
+                    //------------------------------------------------------------------------
+                    // dist = LAB distance + distxy*invwt //dist = sqrt(dist) + sqrt(distxy*invwt);//this is more exact
+                    //------------------------------------------------------------------------
+                    for( int y = y1; y < y2; y++ )
+                    {
+                        if( m_labd ) AssignRowSegment(m_simdlevel, m_labd, klabels,
+                                                      m_width, y, bx1[n], bx2[n], seed, invwt, n);
+                        else AssignRowSegment(m_simdlevel, m_lvec, m_avec, m_bvec, distvec, klabels,
+                                              m_width, y, bx1[n], bx2[n], seed, invwt, n);
                     }
                 }
-            }
+                orphans[band].clear();
+                for( int i = r1*m_width; i < r2*m_width; i++ )
+                {
+                    bool reached = m_labd ? m_labd[i].dist != FLT_MAX : distvec[i] != DBL_MAX;
+                    if( !reached && klabels[i] >= 0 ) orphans[band].push_back(i);
+                }
+                labelchanges[band] = 0;
+                if( prevlabels )
+                {
+                    for( int i = r1*m_width; i < r2*m_width; i++ ) labelchanges[band] += (klabels[i] != prevlabels[i]);
+                }
+            });
             //-----------------------------------------------------------------
             // Recalculate the centroid and store in the seed values
             //-----------------------------------------------------------------
-            //instead of reassigning memory on each iteration, just reset.
-
-            sigmal.assign(numk, 0);
-            sigmaa.assign(numk, 0);
-            sigmab.assign(numk, 0);
-            sigmax.assign(numk, 0);
-            sigmay.assign(numk, 0);
-            clustersize.assign(numk, 0);
-            //------------------------------------
-            //edgesum.assign(numk, 0);
-            //------------------------------------
-
-            {int ind(0);
-            for( int r = 0; r < m_height; r++ )
+            // Each seed sums the pixels of its bounding box carrying its label,
+            // in raster order: the sums are the ones of a single raster scan
+            // whatever the number of threads, without any reduction step.
+            //-----------------------------------------------------------------
+            for( int band = 0; band < numbands; band++ )
             {
-                for( int c = 0; c < m_width; c++ )
+                for( unsigned int o = 0; o < orphans[band].size(); o++ )
                 {
-                    sigmal[klabels[ind]] += m_lvec[ind];
-                    sigmaa[klabels[ind]] += m_avec[ind];
-                    sigmab[klabels[ind]] += m_bvec[ind];
-                    sigmax[klabels[ind]] += c;
-                    sigmay[klabels[ind]] += r;
-                    //------------------------------------
-                    //edgesum[klabels[ind]] += edgemag[ind];
-                    //------------------------------------
-                    clustersize[klabels[ind]] += 1.0;
-                    ind++;
+                    int ind = orphans[band][o];
+                    int k = klabels[ind];
+                    bx1[k] = min(bx1[k], ind%m_width);
+                    bx2[k] = max(bx2[k], ind%m_width+1);
+                    by1[k] = min(by1[k], ind/m_width);
+                    by2[k] = max(by2[k], ind/m_width+1);
                 }
-            }}
+            }
+
+            const int seedsperblock = 64;
+            parallelFor(m_numthreads, (numk+seedsperblock-1)/seedsperblock, [&](int block)
+            {
+                for( int k = block*seedsperblock; k < min(numk, (block+1)*seedsperblock); k++ )
+                {
+                    double suml(0), suma(0), sumb(0), sumx(0), sumy(0), size(0);
+                    for( int r = by1[k]; r < by2[k]; r++ )
+                    {
+                        for( int c = bx1[k]; c < bx2[k]; c++ )
+                        {
+                            int ind = r*m_width + c;
+                            if( klabels[ind] != k ) continue;
+                            double l, a, b;
+                            GetLAB(ind, l, a, b);
+                            suml += l;
+                            suma += a;
+                            sumb += b;
+                            sumx += c;
+                            sumy += r;
+                            size += 1.0;
+                        }
+                    }
+                    sigmal[k] = suml;
+                    sigmaa[k] = suma;
+                    sigmab[k] = sumb;
+                    sigmax[k] = sumx;
+                    sigmay[k] = sumy;
+                    clustersize[k] = size;
+                }
+            });
 
             {for( int k = 0; k < numk; k++ )
             {
@@ -504,6 +601,8 @@ void SLIC::PerformSuperpixelSLIC(vector<double>&				kseedsl,
                 inv[k] = 1.0/clustersize[k];//computing inverse now to multiply, than divide later
             }}
 
+            prevx = kseedsx;
+            prevy = kseedsy;
             {for( int k = 0; k < numk; k++ )
             {
                 kseedsl[k] = sigmal[k]*inv[k];
@@ -515,14 +614,71 @@ void SLIC::PerformSuperpixelSLIC(vector<double>&				kseedsl,
                 //edgesum[k] *= inv[k];
                 //------------------------------------
             }}
+            m_numiterations = itr+1;
+
+            //-----------------------------------------------------------------
+            // Convergence: stop when the seeds or the labels hardly move
+            //-----------------------------------------------------------------
+            bool converged = false;
+            if( m_mindisplacement > 0 )
+            {
+                double displacement(0);
+                for( int k = 0; k < numk; k++ )
+                {
+                    displacement += sqrt((kseedsx[k]-prevx[k])*(kseedsx[k]-prevx[k]) + (kseedsy[k]-prevy[k])*(kseedsy[k]-prevy[k]));
+                }
+                converged |= displacement/numk < m_mindisplacement;
+            }
+            if( m_minlabelchanges > 0 )
+            {
+                long changes(0);
+                for( int band = 0; band < numbands; band++ ) changes += labelchanges[band];
+                converged |= double(changes)/sz < m_minlabelchanges;
+            }
+            if( converged ) break;
         }
 }
+//===========================================================================
+///	FindRoot / UniteRoots
+///
+/// Union-find over pixel indices used by EnforceLabelConnectivity. The root
+/// of a set is always its smallest index, i.e. its first pixel in raster order.
+//===========================================================================
+static inline int FindRoot(const int* parent, int i)
+{
+	while( parent[i] != i ) i = parent[i];
+	return i;
+}
+
+static inline int FindRootCompress(int* parent, int i)
+{
+	while( parent[i] != i )
+	{
+		parent[i] = parent[parent[i]];//path halving
+		i = parent[i];
+	}
+	return i;
+}
+
+static inline void UniteRoots(int* parent, int i, int j)
+{
+	i = FindRootCompress(parent, i);
+	j = FindRootCompress(parent, j);
+	if( i < j ) parent[j] = i;
+	else if( j < i ) parent[i] = j;
+}
+
 //===========================================================================
 ///	EnforceLabelConnectivity
 ///
 ///		1. finding an adjacent label for each new component at the start
 ///		2. if a certain component is too small, assigning the previously found
 ///		    adjacent label to this component, and not incrementing the label.
+///
+/// Components are labelled in parallel on row bands, then the bands are
+/// stitched with a union-find. Components are visited in the raster order of
+/// their first pixel, as the flood fill did, so the labels, the label count
+/// and the SUPSZ >> 2 absorption of small segments are unchanged.
 //===========================================================================
 void SLIC::EnforceLabelConnectivity(
 	const int*					labels,//input labels that need to be corrected to remove stray labels
@@ -540,84 +696,114 @@ void SLIC::EnforceLabelConnectivity(
 
 	const int sz = width*height;
 	const int SUPSZ = sz/K;
-	//nlabels.resize(sz, -1);
-	for( int i = 0; i < sz; i++ ) nlabels[i] = -1;
-	int label(0);
-	int* xvec = new int[sz];
-	int* yvec = new int[sz];
-	int oindex(0);
-	int adjlabel(0);//adjacent label
-	for( int j = 0; j < height; j++ )
+	int* parent = m_workspace->Reserve(m_workspace->xvec, sz);//union-find, then final label of each component
+	int* root = m_workspace->Reserve(m_workspace->yvec, sz);//band component of each pixel, then component of each band component
+	const int numbands = min(height, 4*resolveNbThreads(m_numthreads));
+	vector< vector<int> > bandroots(numbands);
+
+	//-------------------------------------------------------
+	// 4-connected components of each band, and their sizes
+	//-------------------------------------------------------
+	parallelFor(m_numthreads, numbands, [&](int band)
 	{
-		for( int k = 0; k < width; k++ )
+		const int r1 = band*height/numbands;
+		const int r2 = (band+1)*height/numbands;
+		for( int j = r1; j < r2; j++ )
 		{
-			if( 0 > nlabels[oindex] )
+			for( int k = 0; k < width; k++ )
 			{
-				nlabels[oindex] = label;
-				//--------------------
-				// Start a new segment
-				//--------------------
-				xvec[0] = k;
-				yvec[0] = j;
-				//-------------------------------------------------------
-				// Quickly find an adjacent label for use later if needed
-				//-------------------------------------------------------
-				{for( int n = 0; n < 4; n++ )
-				{
-					int x = xvec[0] + dx4[n];
-					int y = yvec[0] + dy4[n];
-					if( (x >= 0 && x < width) && (y >= 0 && y < height) )
-					{
-						int nindex = y*width + x;
-						if(nlabels[nindex] >= 0) adjlabel = nlabels[nindex];
-					}
-				}}
-
-				int count(1);
-				for( int c = 0; c < count; c++ )
-				{
-					for( int n = 0; n < 4; n++ )
-					{
-						int x = xvec[c] + dx4[n];
-						int y = yvec[c] + dy4[n];
-
-						if( (x >= 0 && x < width) && (y >= 0 && y < height) )
-						{
-							int nindex = y*width + x;
+				int i = j*width + k;
+				parent[i] = i;
+				if( k > 0 && labels[i-1] == labels[i] ) UniteRoots(parent, i-1, i);
+				if( j > r1 && labels[i-width] == labels[i] ) UniteRoots(parent, i-width, i);
+			}
+		}
+		bandroots[band].clear();
+		for( int i = r1*width; i < r2*width; i++ )
+		{
+			root[i] = FindRootCompress(parent, i);
+			nlabels[i] = 0;
+			if( root[i] == i ) bandroots[band].push_back(i);
+		}
+		for( int i = r1*width; i < r2*width; i++ ) nlabels[root[i]]++;
+	});
 
-							if( 0 > nlabels[nindex] && labels[oindex] == labels[nindex] )
-							{
-								xvec[count] = x;
-								yvec[count] = y;
-								nlabels[nindex] = label;
-								count++;
-							}
-						}
+	//-------------------------------------------------------
+	// Stitch the band boundaries
+	//-------------------------------------------------------
+	for( int band = 1; band < numbands; band++ )
+	{
+		const int r1 = band*height/numbands;
+		for( int i = r1*width; i < (r1+1)*width; i++ )
+		{
+			if( labels[i] == labels[i-width] ) UniteRoots(parent, root[i], root[i-width]);
+		}
+	}
+	parallelFor(m_numthreads, numbands, [&](int band)
+	{
+		for( unsigned int n = 0; n < bandroots[band].size(); n++ )
+		{
+			int r = bandroots[band][n];
+			root[r] = FindRoot(parent, r);
+		}
+	});
+	//from now on, the component of pixel i is root[root[i]]
+	for( int band = 0; band < numbands; band++ )
+	{
+		for( unsigned int n = 0; n < bandroots[band].size(); n++ )
+		{
+			int r = bandroots[band][n];
+			if( root[r] != r ) nlabels[root[r]] += nlabels[r];
+		}
+	}
 
-					}
-				}
-				//-------------------------------------------------------
-				// If segment size is less then a limit, assign an
-				// adjacent label found before, and decrement label count.
-				//-------------------------------------------------------
-				if(count <= SUPSZ >> 2)
+	//-------------------------------------------------------
+	// Label the components in the raster order of their first pixel
+	//-------------------------------------------------------
+	int label(0);
+	int adjlabel(0);//adjacent label
+	for( int band = 0; band < numbands; band++ )
+	{
+		for( unsigned int n = 0; n < bandroots[band].size(); n++ )
+		{
+			int c = bandroots[band][n];
+			if( root[c] != c ) continue;
+			//-------------------------------------------------------
+			// Find an adjacent label among the components already met
+			//-------------------------------------------------------
+			{for( int d = 0; d < 4; d++ )
+			{
+				int x = c%width + dx4[d];
+				int y = c/width + dy4[d];
+				if( (x >= 0 && x < width) && (y >= 0 && y < height) )
 				{
-					for( int c = 0; c < count; c++ )
-					{
-						int ind = yvec[c]*width+xvec[c];
-						nlabels[ind] = adjlabel;
-					}
-					label--;
+					int nc = root[root[y*width + x]];
+					if( nc < c ) adjlabel = parent[nc];
 				}
+			}}
+			//-------------------------------------------------------
+			// If segment size is less then a limit, assign an
+			// adjacent label found before, and decrement label count.
+			//-------------------------------------------------------
+			if( nlabels[c] <= SUPSZ >> 2 )
+			{
+				parent[c] = adjlabel;
+			}
+			else
+			{
+				parent[c] = label;
 				label++;
 			}
-			oindex++;
 		}
 	}
 	numlabels = label;
 
-	if(xvec) delete [] xvec;
-	if(yvec) delete [] yvec;
+	parallelFor(m_numthreads, numbands, [&](int band)
+	{
+		const int r1 = band*height/numbands;
+		const int r2 = (band+1)*height/numbands;
+		for( int i = r1*width; i < r2*width; i++ ) nlabels[i] = parent[root[root[i]]];
+	});
 }
 
 
@@ -781,7 +967,28 @@ void SLIC::DoSuperpixelSegmentation_ForGivenSuperpixelSize(
         int&						numlabels,
                 const int&					superpixelsize, double M)//weight given to spatial distance
 {
+    DoSuperpixelSegmentation_ForGivenSuperpixelSize(ubuff, width, height, m_ownworkspace, numlabels, superpixelsize, M);
+
+    int sz = width*height;
+    klabels = new int[sz];
+    {for(int i = 0; i < sz; i++ ) klabels[i] = m_ownworkspace.klabels[i];}
+}
 
+//===========================================================================
+///	DoSuperpixelSegmentation_ForGivenSuperpixelSize
+///
+/// Workspace version: the buffers are reserved in (and stay owned by)
+/// workspace, the result is read with workspace.GetLabels().
+//===========================================================================
+void SLIC::DoSuperpixelSegmentation_ForGivenSuperpixelSize(
+        const unsigned int*                            ubuff,//Each 32 bit unsigned int contains ARGB pixel values.
+        const int					width,
+        const int					height,
+        SLICWorkspace&				workspace,
+        int&						numlabels,
+                const int&					superpixelsize, double M)//weight given to spatial distance
+{
+    m_workspace = &workspace;
 
     //------------------------------------------------
     const int STEP = sqrt(double(superpixelsize))+0.5;
@@ -798,16 +1005,25 @@ void SLIC::DoSuperpixelSegmentation_ForGivenSuperpixelSize(
     int sz = m_width*m_height;
     //klabels.resize( sz, -1 );
     //--------------------------------------------------
-    klabels = new int[sz];
+    int* klabels = workspace.Reserve(workspace.klabels, sz);
     for( int s = 0; s < sz; s++ ) klabels[s] = -1;
     //--------------------------------------------------
+    m_lvec = m_avec = m_bvec = NULL;
+    m_labd = NULL;
     if(1)//LAB, the default option
     {
-        DoRGBtoLABConversion(ubuff, m_lvec, m_avec, m_bvec);
+        if(m_storage == SLIC_STORAGE_FLOAT)
+        {
+            m_labd = workspace.Reserve(workspace.labd, sz);
+            m_labconverter.convert(ubuff, sz, &m_labd[0].l, sizeof(LABDPixel)/sizeof(float));
+        }
+        else DoRGBtoLABConversion(ubuff, m_lvec, m_avec, m_bvec);
     }
     else//RGB
     {
-        m_lvec = new double[sz]; m_avec = new double[sz]; m_bvec = new double[sz];
+        m_lvec = workspace.Reserve(workspace.lvec, sz);
+        m_avec = workspace.Reserve(workspace.avec, sz);
+        m_bvec = workspace.Reserve(workspace.bvec, sz);
         for( int i = 0; i < sz; i++ )
         {
                 m_lvec[i] = ubuff[i] >> 16 & 0xff;
@@ -827,10 +1043,12 @@ void SLIC::DoSuperpixelSegmentation_ForGivenSuperpixelSize(
     PerformSuperpixelSLIC(kseedsl, kseedsa, kseedsb, kseedsx, kseedsy, klabels, STEP, edgemag,M);
     numlabels = kseedsl.size();
 
-    int* nlabels = new int[sz];
+    int* nlabels = workspace.Reserve(workspace.nlabels, sz);
     EnforceLabelConnectivity(klabels, m_width, m_height, nlabels, numlabels, double(sz)/double(STEP*STEP));
-    {for(int i = 0; i < sz; i++ ) klabels[i] = nlabels[i];}
-
-    if(nlabels) delete [] nlabels;
+    workspace.klabels.swap(workspace.nlabels);
 
+    //the buffers belong to the workspace
+    m_lvec = m_avec = m_bvec = NULL;
+    m_labd = NULL;
+    m_workspace = &m_ownworkspace;
 }
@@ -1,89 +1,134 @@
 #include "asari.h"
 #include "SLIC.h"
 #include "ltp.h"
+#include "parallel.h"
 
 #include <iostream>
 #include <fstream>
 #include <limits>
+#include <queue>
 
 Asari::Asari(){
-    this->image=NULL;
-    this->result=NULL;
+    this->slicWorkspace=NULL;
 
 }
 
-Asari::~Asari(){
-    if(this->image) ImFree(&(this->image));
-    if(this->result) ImFree(&(this->result));
+Asari::Asari(Parameters &param, Image image, bool useTexture, SLICWorkspace *workspace) : Asari(param,image,IMAGE_COPY,useTexture,workspace)
+{
+
 }
 
-Asari::Asari(Parameters &param, Image image, bool useTexture) : param(param), useTexture(useTexture)
+Asari::Asari(Parameters &param, Image image, ImageOwnership ownership, bool useTexture, SLICWorkspace *workspace) : slicWorkspace(workspace), param(param), useTexture(useTexture)
 {
-    this->image=ImCopy(image);
-    this->result=ImCopy(image);
+    if(ownership==IMAGE_BORROW){
+        this->image=shared_ptr<struct sImage>(image,[](Image){});
+    }else{
+        this->image=shared_ptr<struct sImage>(ImCopy(image),ImageDeleter());
+    }
     initializeOversegmntation();
     initializeSuperpixelsFeatures();
 
 }
 
 void Asari::changeParam(Parameters &param){
+    bool sameSlic=this->param.sameSlic(param);
+    bool sameLtp=this->param.sameLtp(param);
     this->param=param;
+
+    //redo only the steps depending on the changed parameters
+    if(!sameSlic){
+        initializeOversegmntation();
+        initializeSuperpixelsFeatures();
+    }else if(useTexture && !sameLtp){
+        initializeSuperpixelsFeatures();
+    }else{
+        restoreInitialState();
+    }
 }
 
 Asari Asari::copy(){
     Asari res;
-    res.image=ImCopy(image);
-    res.result=ImCopy(result);
-    res.superpixelsLabels=this->superpixelsLabels;
+    res.image=this->image;
+    res.slicLabels=this->slicLabels;
     res.nbSuperpixels=this->nbSuperpixels;/*!< number of superpixesl */
-    res.superpixelsFeatures=this->superpixelsFeatures;
+    res.nbSlicIterations=this->nbSlicIterations;
+    res.initialFeatures=this->initialFeatures;
+    res.state=this->state;
     res.param=this->param;
-    res.spRefSize=this->spRefSize;
+    res.useTexture=this->useTexture;
 
     return res;
 }
 
-void Asari::compute(){
-
-    int nbSp=superpixelsFeatures.size();
-    int i=0;
+void Asari::detachState(){
+    if(state.use_count()>1){
+        state=make_shared<MergeState>(*state);
+    }
+}
 
-    do{
-        nbSp=superpixelsFeatures.size();
-        computeOverSegmentationUsingMerging();
-        i++;
-    }while(nbSp!=int(superpixelsFeatures.size())&& i<10 && superpixelsFeatures.size()>=500);
+void Asari::compute(){
+    detachState();
+
+    if(param.mergeWithPriorityQueue){
+        computeOverSegmentationUsingPriorityQueue();
+    }else{
+        int nbSp=state->superpixelsFeatures.size();
+        int i=0;
+
+        do{
+            nbSp=state->superpixelsFeatures.size();
+            computeOverSegmentationUsingMerging();
+            i++;
+        }while(nbSp!=state->superpixelsFeatures.size()&& i<10 && state->superpixelsFeatures.size()>=500);
+    }
 
+    //final label of each slic superpixel: rank of the superpixel it has been merged into
+    vector<int> finalLabels(nbSuperpixels,-1);
     int spI=0;
-    int width=ImNbCol(image);
-    for(map<int,SuperpixelAsari>::iterator sp=superpixelsFeatures.begin();sp!=superpixelsFeatures.end();sp++){
-        //update pixels labels
-        for(int i=0;i<int((sp->second).pixelsCoordinates.size());i++){
-            int x =(sp->second).pixelsCoordinates[i].x();
-            int y = (sp->second).pixelsCoordinates[i].y();
-            int j=x+y*width;
-            //change index
-            superpixelsLabels[j]=spI;
-        }
+    for(int idx=state->superpixelsFeatures.first();idx>=0;idx=state->superpixelsFeatures.next(idx)){
+        finalLabels[idx]=spI;
         spI++;
     }
+    for(int i=0;i<nbSuperpixels;i++){
+        finalLabels[i]=finalLabels[state->fuAlgo.findRegion(i)];
+    }
+
+    state->finalLabels.swap(finalLabels);
+}
+
+void Asari::labelPixels(const vector<int>& labels, int* pixelsLabels) const{
+    const vector<int>& slicLabels=*this->slicLabels;
+    for(unsigned int j=0;j<slicLabels.size();j++){
+        pixelsLabels[j]=labels[slicLabels[j]];
+    }
+}
+
+vector<int> Asari::labelPixels(const vector<int>& labels) const{
+    vector<int> pixelsLabels(slicLabels->size());
+    labelPixels(labels,pixelsLabels.data());
+    return pixelsLabels;
 }
 
 int Asari::getNbSp(){
-    return superpixelsFeatures.size();
+    return state->superpixelsFeatures.size();
+}
+
+int Asari::getNbSlicIterations(){
+    return nbSlicIterations;
 }
 
 void Asari::clearResult(){
-    result=ImCopy(image);
+    result.reset(ImCopy(image.get()));
 }
 
 void Asari::drawSuperpixelsBoundaries(){
-    int height=ImNbRow(image);
-    int width=ImNbCol(image);
+    int height=ImNbRow(image.get());
+    int width=ImNbCol(image.get());
 
-    unsigned char** red=ImGetR(result);
-    unsigned char** green=ImGetG(result);
-    unsigned char** blue=ImGetB(result);
+    unsigned char** red=ImGetR(result.get());
+    unsigned char** green=ImGetG(result.get());
+    unsigned char** blue=ImGetB(result.get());
+    vector<int> superpixelsLabels=getSuperpixels();
     for(int y=0;y<height;y++){
         for(int x=0;x<width;x++){
             int iLabel=superpixelsLabels[x+y*width];
@@ -111,28 +156,74 @@ void Asari::drawSuperpixelsBoundaries(){
 Image Asari::getResult(){
     clearResult();
     drawSuperpixelsBoundaries();
-    return result;
+    return result.get();
 }
 
 
 vector<int> Asari::getSuperpixels(){
-    return superpixelsLabels;
+    return labelPixels(state->finalLabels);
+}
+
+void Asari::getSuperpixels(int* labels) const{
+    labelPixels(state->finalLabels,labels);
+}
+
+int Asari::computeLabels(Parameters& param, Image image, int* labels, bool useTexture, SLICWorkspace* workspace){
+    Asari asari(param,image,IMAGE_BORROW,useTexture,workspace);
+    asari.compute();
+    asari.getSuperpixels(labels);
+    return asari.getNbSp();
+}
+
+const MergeTree& Asari::getMergeTree() const{
+    return state->mergeTree;
+}
+
+vector<int> Asari::getSuperpixelsAtNbRegions(int nbRegions, int& nbSp) const{
+    vector<int> labels;
+    nbSp=state->mergeTree.cutAtNbRegions(nbRegions,labels);
+    return labelPixels(labels);
+}
+
+vector<int> Asari::getSuperpixelsAtDistance(double distance, int& nbSp) const{
+    vector<int> labels;
+    nbSp=state->mergeTree.cutAtDistance(distance,labels);
+    return labelPixels(labels);
+}
+
+double Asari::colorDistance(const SuperpixelAsari& sp1, const SuperpixelAsari& sp2) const{
+    //euclidian distance between average RGB color
+    double sp1RedMean=sp1.red/sp1.nbPixels;
+    double sp1GreenMean=sp1.green/sp1.nbPixels;
+    double sp1BlueMean=sp1.blue/sp1.nbPixels;
+    double sp2RedMean=sp2.red/sp2.nbPixels;
+    double sp2GreenMean=sp2.green/sp2.nbPixels;
+    double sp2BlueMean=sp2.blue/sp2.nbPixels;
+    double dc=sqrt(pow(sp1RedMean-sp2RedMean,2)+pow(sp1GreenMean-sp2GreenMean,2)+pow(sp1BlueMean-sp2BlueMean,2));
+    dc/=sqrt(pow(255,2)+pow(255,2)+pow(255,2));
+    return dc;
+}
+
+double Asari::textureDistance(const SuperpixelAsari& sp1, const SuperpixelAsari& sp2) const{
+    //chi2 distance between LTP histograms
+    double dt=0;
+    double nbNZero=0;
+    LTPHistogram::accumulateChi2(bestSimdLevel(),sp2.ltpHistN,sp2.nbPixels,sp1.ltpHistN,sp1.nbPixels,dt,nbNZero);
+    LTPHistogram::accumulateChi2(bestSimdLevel(),sp2.ltpHistP,sp2.nbPixels,sp1.ltpHistP,sp1.nbPixels,dt,nbNZero);
+
+    dt/=double(nbNZero);
+    return dt;
 }
 
 void Asari::mergeUsingColor(int spIdx){
-    double sp1RedMean=superpixelsFeatures[spIdx].red/superpixelsFeatures[spIdx].nbPixels;
-    double sp1GreenMean=superpixelsFeatures[spIdx].green/superpixelsFeatures[spIdx].nbPixels;
-    double sp1BlueMean=superpixelsFeatures[spIdx].blue/superpixelsFeatures[spIdx].nbPixels;
+    const SuperpixelAsari& sp1=state->superpixelsFeatures[spIdx];
     int minIdx=-1;
     double minDc=256;
-    for(auto idx=superpixelsFeatures[spIdx].neighboors.begin();idx!=superpixelsFeatures[spIdx].neighboors.end();idx++){
-        if(superpixelsFeatures[*idx].pixelsCoordinates.size() + superpixelsFeatures[spIdx].pixelsCoordinates.size()<spRefSize){
-            if(superpixelsFeatures[*idx].homogeneous){
-                double sp2RedMean=superpixelsFeatures[*idx].red/superpixelsFeatures[*idx].nbPixels;
-                double sp2GreenMean=superpixelsFeatures[*idx].green/superpixelsFeatures[*idx].nbPixels;
-                double sp2BlueMean=superpixelsFeatures[*idx].blue/superpixelsFeatures[*idx].nbPixels;
-                double dc=sqrt(pow(sp1RedMean-sp2RedMean,2)+pow(sp1GreenMean-sp2GreenMean,2)+pow(sp1BlueMean-sp2BlueMean,2));
-                dc/=sqrt(pow(255,2)+pow(255,2)+pow(255,2));
+    for(auto idx=sp1.neighboors.begin();idx!=sp1.neighboors.end();idx++){
+        const SuperpixelAsari& sp2=state->superpixelsFeatures[*idx];
+        if(sp2.nbPixels + sp1.nbPixels<state->spRefSize){
+            if(sp2.homogeneous){
+                double dc=colorDistance(sp1,sp2);
                 if(dc<minDc){
                     minDc=dc;
                     minIdx=*idx;
@@ -143,7 +234,7 @@ void Asari::mergeUsingColor(int spIdx){
     }
     if(minIdx>=0){
         if(minDc<param.similarityThreshold){
-            mergeSuperpixels(spIdx,minIdx);
+            mergeSuperpixels(spIdx,minIdx,minDc);
         }
     }
 }
@@ -153,40 +244,16 @@ void Asari::mergeUsingTexture(int spIdx){
     double minIdx=-1;
     double minDt=numeric_limits<double>::max();
 
-    double sp1RedMean=superpixelsFeatures[spIdx].red/superpixelsFeatures[spIdx].nbPixels;
-    double sp1GreenMean=superpixelsFeatures[spIdx].green/superpixelsFeatures[spIdx].nbPixels;
-    double sp1BlueMean=superpixelsFeatures[spIdx].blue/superpixelsFeatures[spIdx].nbPixels;
-    for(auto idx=superpixelsFeatures[spIdx].neighboors.begin();idx!=superpixelsFeatures[spIdx].neighboors.end();idx++){
-        if(superpixelsFeatures[*idx].pixelsCoordinates.size() + superpixelsFeatures[spIdx].pixelsCoordinates.size()<spRefSize){
-            if(!superpixelsFeatures[*idx].homogeneous){
-                //compute  texture distance (chi2 distance between LTP histograms)
-                double dt=0;
-                double nbNZero=0;
-                for(unsigned int i=0;i<superpixelsFeatures[spIdx].ltpHistN.size();i++){
-                    double h1=superpixelsFeatures[*idx].ltpHistN[i]/double(superpixelsFeatures[*idx].pixelsCoordinates.size());
-                    double h2=superpixelsFeatures[spIdx].ltpHistN[i]/double(superpixelsFeatures[spIdx].pixelsCoordinates.size());
-                    if(h1>0||h2>0){
-                        dt+=pow(h1-h2,2)/(h1+h2);
-                        nbNZero++;
-                    }
-                }
-                for(unsigned int i=0;i<superpixelsFeatures[spIdx].ltpHistP.size();i++){
-                    double h1=superpixelsFeatures[*idx].ltpHistP[i]/double(superpixelsFeatures[*idx].pixelsCoordinates.size());
-                    double h2=superpixelsFeatures[spIdx].ltpHistP[i]/double(superpixelsFeatures[spIdx].pixelsCoordinates.size());
-                    if(h1>0||h2>0){
-                        dt+=pow(h1-h2,2)/(h1+h2);
-                        nbNZero++;
-                    }
-                }
-
-                dt/=double(nbNZero);
+    const SuperpixelAsari& sp1=state->superpixelsFeatures[spIdx];
+    for(auto idx=sp1.neighboors.begin();idx!=sp1.neighboors.end();idx++){
+        const SuperpixelAsari& sp2=state->superpixelsFeatures[*idx];
+        if(sp2.nbPixels + sp1.nbPixels<state->spRefSize){
+            if(!sp2.homogeneous){
+                //compute  texture distance
+                double dt=textureDistance(sp1,sp2);
 
-                //compute color distance (euclidian distance between average RGB color)
-                double sp2RedMean=superpixelsFeatures[*idx].red/superpixelsFeatures[*idx].nbPixels;
-                double sp2GreenMean=superpixelsFeatures[*idx].green/superpixelsFeatures[*idx].nbPixels;
-                double sp2BlueMean=superpixelsFeatures[*idx].blue/superpixelsFeatures[*idx].nbPixels;
-                double dc=sqrt(pow(sp1RedMean-sp2RedMean,2)+pow(sp1GreenMean-sp2GreenMean,2)+pow(sp1BlueMean-sp2BlueMean,2));
-                dc/=sqrt(pow(255,2)+pow(255,2)+pow(255,2));
+                //compute color distance
+                double dc=colorDistance(sp1,sp2);
 
                 //compute simalirarity distance
                 dt+=dc;
@@ -200,34 +267,42 @@ void Asari::mergeUsingTexture(int spIdx){
     }
     if(minIdx>=0){
         if(minDt<param.similarityThreshold){
-            mergeSuperpixels(spIdx,minIdx);
+            mergeSuperpixels(spIdx,minIdx,minDt);
         }
     }
 
 
 }
 
+double Asari::mergingDistance(int idx1, int idx2) const{
+    const SuperpixelAsari& sp1=state->superpixelsFeatures[idx1];
+    const SuperpixelAsari& sp2=state->superpixelsFeatures[idx2];
+    //untextured superpixels only merge with untextured ones, and textured with textured
+    if(sp1.homogeneous!=sp2.homogeneous) return numeric_limits<double>::infinity();
+    if(sp1.homogeneous) return colorDistance(sp1,sp2);
+    double dt=textureDistance(sp1,sp2);
+    dt+=colorDistance(sp1,sp2);
+    return dt;
+}
+
 void Asari::updateSpRefSize(){
-    spRefSize=0;
-    for(auto it=superpixelsFeatures.begin();it!=superpixelsFeatures.end();it++){
-        spRefSize+=it->second.pixelsCoordinates.size();
+    state->spRefSize=0;
+    for(int idx=state->superpixelsFeatures.first();idx>=0;idx=state->superpixelsFeatures.next(idx)){
+        state->spRefSize+=state->superpixelsFeatures[idx].nbPixels;
     }
-    spRefSize/=superpixelsFeatures.size();
-    spRefSize=spRefSize*param.regularityParam;
+    state->spRefSize/=state->superpixelsFeatures.size();
+    state->spRefSize=state->spRefSize*param.regularityParam;
 }
 
 void Asari::computeOverSegmentationUsingMerging(){
-    //inference
-    map<int,SuperpixelAsari>::iterator it=superpixelsFeatures.begin();
+    //inference: merging never removes the current superpixel, so the next live one stays valid
+    for(int idx=state->superpixelsFeatures.first();idx>=0;idx=state->superpixelsFeatures.next(idx)){
 
-    while(it!=superpixelsFeatures.end()){
-
-        if(superpixelsFeatures[it->first].homogeneous){
-            mergeUsingColor(it->first);
+        if(state->superpixelsFeatures[idx].homogeneous){
+            mergeUsingColor(idx);
         }else{
-            mergeUsingTexture(it->first);
+            mergeUsingTexture(idx);
         }
-        it++;
     }
 
     updateSpRefSize();
@@ -236,64 +311,164 @@ void Asari::computeOverSegmentationUsingMerging(){
 
 
 
-void Asari::mergeSuperpixels(int idx1, int idx2){
+/**
+ * @brief Candidate merge of two adjacent superpixels (edge of the region adjacency graph)
+ *
+ * The versions of both superpixels are recorded when the distance is computed: the candidate
+ * is out of date as soon as one of them has changed or has been merged.
+ */
+struct MergeCandidate{
+    double dist;
+    int idx1;/*!< lowest label */
+    int idx2;
+    int version1;
+    int version2;
+    double nbPixels;/*!< size of the merged superpixel */
+
+    /**
+     * @brief operator > order of the priority queue: distance, then labels
+     */
+    bool operator>(const MergeCandidate& other) const{
+        if(dist!=other.dist) return dist>other.dist;
+        if(idx1!=other.idx1) return idx1>other.idx1;
+        return idx2>other.idx2;
+    }
+};
+
+/**
+ * @brief Order of the candidates waiting for the regularity criterion: smallest merged size first
+ */
+struct MergeCandidateLargerSize{
+    bool operator()(const MergeCandidate& c1, const MergeCandidate& c2) const{
+        if(c1.nbPixels!=c2.nbPixels) return c1.nbPixels>c2.nbPixels;
+        return c1>c2;
+    }
+};
+
+void Asari::computeOverSegmentationUsingPriorityQueue(){
+    vector<int> versions(state->superpixelsFeatures.capacity(),0);
+    priority_queue<MergeCandidate,vector<MergeCandidate>,greater<MergeCandidate> > candidates;
+    //candidates too large for the current reference size
+    priority_queue<MergeCandidate,vector<MergeCandidate>,MergeCandidateLargerSize> tooLarge;
+
+    double nbPixels=0;
+    for(int idx=state->superpixelsFeatures.first();idx>=0;idx=state->superpixelsFeatures.next(idx)){
+        nbPixels+=state->superpixelsFeatures[idx].nbPixels;
+    }
+
+    //score every edge of the region adjacency graph once
+    for(int idx=state->superpixelsFeatures.first();idx>=0;idx=state->superpixelsFeatures.next(idx)){
+        const NeighbourList& neighboors=state->superpixelsFeatures[idx].neighboors;
+        for(auto it=neighboors.upper_bound(idx);it!=neighboors.end();it++){
+            double dist=mergingDistance(idx,*it);
+            if(dist<param.similarityThreshold){
+                MergeCandidate candidate={dist,idx,*it,0,0,state->superpixelsFeatures[idx].nbPixels+state->superpixelsFeatures[*it].nbPixels};
+                candidates.push(candidate);
+            }
+        }
+    }
+
+    int target=max(param.targetNbSuperpixels,1);
+    state->spRefSize=nbPixels/state->superpixelsFeatures.size()*param.regularityParam;
+    while(!candidates.empty() && state->superpixelsFeatures.size()>target){
+        MergeCandidate candidate=candidates.top();
+        candidates.pop();
+        if(!state->superpixelsFeatures.isAlive(candidate.idx1) || !state->superpixelsFeatures.isAlive(candidate.idx2)
+                || versions[candidate.idx1]!=candidate.version1 || versions[candidate.idx2]!=candidate.version2){
+            continue;
+        }
+        if(candidate.nbPixels>=state->spRefSize){
+            //regularity criterion: may be fulfilled once the reference size has grown
+            tooLarge.push(candidate);
+            continue;
+        }
+
+        mergeSuperpixels(candidate.idx1,candidate.idx2,candidate.dist);
+        int idx=candidate.idx1;
+        versions[idx]++;
+
+        //only the edges of the merged superpixel are scored again
+        const NeighbourList& neighboors=state->superpixelsFeatures[idx].neighboors;
+        for(auto it=neighboors.begin();it!=neighboors.end();it++){
+            double dist=mergingDistance(idx,*it);
+            if(dist<param.similarityThreshold){
+                MergeCandidate updated={dist,min(idx,*it),max(idx,*it),versions[min(idx,*it)],versions[max(idx,*it)],
+                                        state->superpixelsFeatures[idx].nbPixels+state->superpixelsFeatures[*it].nbPixels};
+                candidates.push(updated);
+            }
+        }
+
+        //fewer superpixels: the reference size grows and may release waiting candidates
+        state->spRefSize=nbPixels/state->superpixelsFeatures.size()*param.regularityParam;
+        while(!tooLarge.empty() && tooLarge.top().nbPixels<state->spRefSize){
+            candidates.push(tooLarge.top());
+            tooLarge.pop();
+        }
+    }
+
+    updateSpRefSize();
+}
+
+void Asari::mergeSuperpixels(int idx1, int idx2, double distance){
     if(idx1 != idx2){
-        int prevNbSp=superpixelsFeatures.size() ;
+        int prevNbSp=state->superpixelsFeatures.size() ;
 
-        SuperpixelAsari sp2=superpixelsFeatures[idx2];
+        //both references stay valid: the store never reallocates while merging
+        SuperpixelAsari& sp1=state->superpixelsFeatures[idx1];
+        const SuperpixelAsari& sp2=state->superpixelsFeatures[idx2];
 
         //update average color
         //and number of pixel
-        superpixelsFeatures[idx1].red+=sp2.red;
-        superpixelsFeatures[idx1].green+=sp2.green;
-        superpixelsFeatures[idx1].blue+=sp2.blue;
-        superpixelsFeatures[idx1].nbPixels+=sp2.nbPixels;
-
-        //add pixel coordinates of the second superpixels
-        for(int i=0;i<int(sp2.pixelsCoordinates.size());i++){
-            superpixelsFeatures[idx1].pixelsCoordinates.push_back(sp2.pixelsCoordinates[i]);
-        }
+        sp1.red+=sp2.red;
+        sp1.green+=sp2.green;
+        sp1.blue+=sp2.blue;
+        sp1.nbPixels+=sp2.nbPixels;
+
+        //pixels of the second superpixel now belong to the first one
+        state->fuAlgo.unionCC(idx2,idx1);
+        state->mergeTree.record(idx1,idx2,distance);
         if(useTexture){
             //merge ltp histograms
-            for(unsigned int i=0;i<sp2.ltpHistN.size();i++){
-                superpixelsFeatures[idx1].ltpHistN[i]+=sp2.ltpHistN[i];
-                superpixelsFeatures[idx1].ltpHistP[i]+=sp2.ltpHistP[i];
-            }
-            superpixelsFeatures[idx1].nbHomogeneous+=sp2.nbHomogeneous;
+            sp1.ltpHistN.merge(sp2.ltpHistN);
+            sp1.ltpHistP.merge(sp2.ltpHistP);
+            sp1.nbHomogeneous+=sp2.nbHomogeneous;
             //test if superpixel is homogeneous
-            superpixelsFeatures[idx1].homogeneous=(superpixelsFeatures[idx1].nbHomogeneous/double(sp2.pixelsCoordinates.size()))>=param.spUnTexturedThreshold;
+            sp1.homogeneous=(sp1.nbHomogeneous/sp2.nbPixels)>=param.spUnTexturedThreshold;
         }
-        assert(superpixelsFeatures[idx1].pixelsCoordinates.size()==superpixelsFeatures[idx1].nbPixels);
 
         //update neighboors of the second superpixels
         for(auto it=sp2.neighboors.begin();it!=sp2.neighboors.end();it++){
             if(*it!=idx1){
-                superpixelsFeatures[*it].neighboors.erase(idx2);
-                superpixelsFeatures[*it].neighboors.insert(idx1);
-                superpixelsFeatures[idx1].neighboors.insert(*it);
+                NeighbourList& neighboors=state->superpixelsFeatures[*it].neighboors;
+                neighboors.erase(idx2);
+                neighboors.insert(idx1);
             }
         }
+        sp1.neighboors.unite(sp2.neighboors);
 
 
-        //remove sp2 from neighbors of sp1
-        superpixelsFeatures[idx1].neighboors.erase(idx2);
+        //remove sp1 and sp2 from neighbors of sp1
+        sp1.neighboors.erase(idx1);
+        sp1.neighboors.erase(idx2);
         //remove sp2
-        assert(superpixelsFeatures.find(idx2)!=superpixelsFeatures.end());
-        superpixelsFeatures.erase(idx2);
-        assert((int)superpixelsFeatures.size()<prevNbSp);
+        state->superpixelsFeatures.erase(idx2);
+        assert((int)state->superpixelsFeatures.size()<prevNbSp);
     }
 
 }
 
 void Asari::initializeOversegmntation(){
-    int height=ImNbRow(image);
-    int width=ImNbCol(image);
+    int height=ImNbRow(image.get());
+    int width=ImNbCol(image.get());
     int nbPixels=width*height;
-    unsigned int* data=new unsigned int[nbPixels];
-
-    unsigned char** red=ImGetR(image);
-    unsigned char** green=ImGetG(image);
-    unsigned char** blue=ImGetB(image);
+    //buffers of the caller's workspace are reused between images
+    SLICWorkspace localWorkspace;
+    SLICWorkspace& workspace=slicWorkspace ? *slicWorkspace : localWorkspace;
+    unsigned int* data=workspace.GetColorBuffer(nbPixels);
+
+    unsigned char** red=ImGetR(image.get());
+    unsigned char** green=ImGetG(image.get());
+    unsigned char** blue=ImGetB(image.get());
     for(int y=0;y<height;y++){
         for(int x=0;x<width;x++){
             unsigned int compactedColor=red[y][x];
@@ -308,83 +483,172 @@ void Asari::initializeOversegmntation(){
     }
 
 
-    int* labelsSlic;
-
     int numSegm;
 
     SLIC slic;
+    slic.SetLABConversionMode(param.slicFastLab ? LAB_FAST : LAB_EXACT);
+    slic.SetNumThreads(param.nbThreads);
+    slic.SetStorageMode(param.slicSinglePrecision ? SLIC_STORAGE_FLOAT : SLIC_STORAGE_DOUBLE);
+    slic.SetConvergence(param.slicMaxIterations,param.slicMinSeedDisplacement,param.slicMinLabelChanges);
 
     int spSize=max(width*height*param.slicSpSizeFactor,param.minSizeFactor);
-    slic.DoSuperpixelSegmentation_ForGivenSuperpixelSize(data,width,height,labelsSlic,numSegm,spSize,param.slicCompacity);
+    slic.DoSuperpixelSegmentation_ForGivenSuperpixelSize(data,width,height,workspace,numSegm,spSize,param.slicCompacity);
 
-    superpixelsLabels.assign(labelsSlic,labelsSlic+width*height);
+    slicLabels=make_shared<const vector<int> >(workspace.GetLabels(),workspace.GetLabels()+width*height);
     nbSuperpixels=numSegm;
-    delete data;
-    delete labelsSlic;
+    nbSlicIterations=slic.GetNumIterations();
 
 }
 
 
-void Asari::initializeSuperpixelsFeatures(){
-    superpixelsFeatures.clear();
-
-    int height=ImNbRow(image);
-    int width=ImNbCol(image);
-
-    unsigned char** red=ImGetR(image);
-    unsigned char** green=ImGetG(image);
-    unsigned char** blue=ImGetB(image);
-
-
-    for(int i=0;i<nbSuperpixels;i++){
-        superpixelsFeatures.insert(pair<int,SuperpixelAsari>(i,SuperpixelAsari()));
-    }
+/**
+ * @brief Partial features of the superpixels met by a band of rows
+ */
+struct BandFeatures{
+    vector<int> localIndex;/*!< index in superpixels of each slic label, -1 if not met */
+    vector<SuperpixelAsari> superpixels;
 
-    if(useTexture){
-        LTP ltpAlgo(param.ltpThr,param.ltpUniThr);
-        ltps=ltpAlgo.computeLTP(image);
+    SuperpixelAsari& get(int label){
+        if(localIndex[label]<0){
+            localIndex[label]=superpixels.size();
+            superpixels.push_back(SuperpixelAsari());
+        }
+        return superpixels[localIndex[label]];
     }
+};
 
-    for(int y=0;y<height;y++){
-        for(int x=0;x<width;x++){
-            int iLabel = superpixelsLabels[x+y*width];
-            //compute average colore
-            superpixelsFeatures[iLabel].red+= red[y][x];
-            superpixelsFeatures[iLabel].green+= green[y][x];
-            superpixelsFeatures[iLabel].blue+= blue[y][x];
-            superpixelsFeatures[iLabel].nbPixels++;
-            superpixelsFeatures[iLabel].pixelsCoordinates.push_back(Point(x,y));
-
-            if(useTexture){
-                //update ltp histograms
-                superpixelsFeatures[iLabel].ltpHistN[ltps[x+y*width].ltpN]++;
-                superpixelsFeatures[iLabel].ltpHistP[ltps[x+y*width].ltpP]++;
-                if( ltps[x+y*width].homogeneous){
-                    superpixelsFeatures[iLabel].nbHomogeneous++;
+void Asari::initializeSuperpixelsFeatures(){
+    int height=ImNbRow(image.get());
+    int width=ImNbCol(image.get());
+
+    unsigned char** red=ImGetR(image.get());
+    unsigned char** green=ImGetG(image.get());
+    unsigned char** blue=ImGetB(image.get());
+
+
+    const vector<int>& slicLabels=*this->slicLabels;
+    shared_ptr<SuperpixelStore> initialFeatures=make_shared<SuperpixelStore>();
+    initialFeatures->initialize(nbSuperpixels);
+
+    LTP ltpAlgo(param.ltpThr,param.ltpUniThr);
+
+    //each band of rows accumulates the features of the superpixels it meets
+    int nbBands=min(height,resolveNbThreads(param.nbThreads));
+    vector<BandFeatures> bands(nbBands);
+    parallelFor(param.nbThreads,nbBands,[&](int band){
+        BandFeatures& features=bands[band];
+        features.localIndex.assign(nbSuperpixels,-1);
+        int y1=band*height/nbBands;
+        int y2=(band+1)*height/nbBands;
+        //LTP rows are accumulated as they are computed, without an image of LTP
+        LTPRowConsumer accumulateRow=[&](int y,const unsigned char* codesP,const unsigned char* codesN,const unsigned char* homogeneous){
+            for(int x=0;x<width;x++){
+                SuperpixelAsari& sp=features.get(slicLabels[x+y*width]);
+                //compute average colore
+                sp.red+= red[y][x];
+                sp.green+= green[y][x];
+                sp.blue+= blue[y][x];
+                sp.nbPixels++;
+
+                if(useTexture){
+                    //update ltp histograms
+                    sp.ltpHistN.add(codesN[x]);
+                    sp.ltpHistP.add(codesP[x]);
+                    if( homogeneous[x]){
+                        sp.nbHomogeneous++;
+                    }
                 }
             }
+        };
+        if(useTexture){
+            ltpAlgo.computeLTP(image.get(),y1,y2,accumulateRow);
+        }else{
+            for(int y=y1;y<y2;y++){
+                accumulateRow(y,NULL,NULL,NULL);
+            }
+        }
 
-            //neighboors
-            int vMin=max(y-1,0);
-            int vMax=min(y+1,height-1);
-            int uMin=max(x-1,0);
-            int uMax=min(x+1,width-1);
-            for(int v=vMin;v<=vMax;v++){
-                for(int u=uMin;u<=uMax;u++){
-                    if(iLabel!=superpixelsLabels[u+v*width]) superpixelsFeatures[iLabel].neighboors.insert(superpixelsLabels[u+v*width]);
+        //neighboors: 8-adjacency is symmetric, so each pair of adjacent pixels is visited once
+        //(right, bottom-left, bottom, bottom-right) and recorded in both superpixels
+        const int du[4]={1,-1,0,1};
+        const int dv[4]={0,1,1,1};
+        for(int y=y1;y<y2;y++){
+            for(int x=0;x<width;x++){
+                int iLabel = slicLabels[x+y*width];
+                for(int n=0;n<4;n++){
+                    int u=x+du[n];
+                    int v=y+dv[n];
+                    if(u<0 || u>=width || v>=height) continue;
+                    int jLabel=slicLabels[u+v*width];
+                    if(iLabel!=jLabel){
+                        features.get(iLabel).neighboors.append(jLabel);
+                        features.get(jLabel).neighboors.append(iLabel);
+                    }
                 }
             }
         }
-    }
+        for(unsigned int i=0;i<features.superpixels.size();i++){
+            features.superpixels[i].neighboors.sortUnique();
+        }
+    });
+
+    //reduce the partial features of each superpixel in band order: counts and sums of
+    //integer values are exact, so the result does not depend on the number of bands
+    const int labelsPerTask=256;
+    parallelFor(param.nbThreads,(nbSuperpixels+labelsPerTask-1)/labelsPerTask,[&](int task){
+        int label2=min(nbSuperpixels,(task+1)*labelsPerTask);
+        for(int label=task*labelsPerTask;label<label2;label++){
+            SuperpixelAsari& sp=(*initialFeatures)[label];
+            bool first=true;
+            for(int band=0;band<nbBands;band++){
+                int local=bands[band].localIndex[label];
+                if(local<0) continue;
+                SuperpixelAsari& partial=bands[band].superpixels[local];
+                if(first){
+                    swap(sp,partial);
+                    first=false;
+                    continue;
+                }
+                sp.red+=partial.red;
+                sp.green+=partial.green;
+                sp.blue+=partial.blue;
+                sp.nbPixels+=partial.nbPixels;
+                sp.nbHomogeneous+=partial.nbHomogeneous;
+                sp.ltpHistN.merge(partial.ltpHistN);
+                sp.ltpHistP.merge(partial.ltpHistP);
+                sp.neighboors.unite(partial.neighboors);
+            }
+        }
+    });
 
+    //proportion of homogeneous pixels
     if(useTexture){
         for(int i=0;i<nbSuperpixels;i++){
-            superpixelsFeatures[i].homogeneous=(superpixelsFeatures[i].nbHomogeneous/=double(superpixelsFeatures[i].pixelsCoordinates.size()))>=param.spUnTexturedThreshold;
+            (*initialFeatures)[i].nbHomogeneous/=(*initialFeatures)[i].nbPixels;
         }
     }
+    this->initialFeatures=initialFeatures;
 
+    restoreInitialState();
 
-    updateSpRefSize();
+}
+
+void Asari::restoreInitialState(){
+    state=make_shared<MergeState>();
+    state->superpixelsFeatures=*initialFeatures;
+    state->fuAlgo.initialize(nbSuperpixels);
+    state->mergeTree.initialize(nbSuperpixels);
+    state->finalLabels.resize(nbSuperpixels);
+    for(int i=0;i<nbSuperpixels;i++){
+        state->finalLabels[i]=i;
+    }
 
+    if(useTexture){
+        for(int i=0;i<nbSuperpixels;i++){
+            state->superpixelsFeatures[i].homogeneous=state->superpixelsFeatures[i].nbHomogeneous>=param.spUnTexturedThreshold;
+        }
+    }
+
+    updateSpRefSize();
 }
 
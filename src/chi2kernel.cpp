@@ -0,0 +1,113 @@
+#include "chi2kernel.h"
+
+#ifdef ASARI_X86_SIMD
+#include <immintrin.h>
+#endif
+
+static void AccumulateChi2Scalar(const int* hist1, double nbPixels1,
+                                 const int* hist2, double nbPixels2,
+                                 int i, int nbBins, double& dist, double& nbNonZero)
+{
+    for( ; i < nbBins; i++ )
+    {
+        double h1 = hist1[i]/nbPixels1;
+        double h2 = hist2[i]/nbPixels2;
+        if( h1 > 0 || h2 > 0 )
+        {
+            double d = h1 - h2;
+            dist += d*d/(h1 + h2);
+            nbNonZero++;
+        }
+    }
+}
+
+#ifdef ASARI_X86_SIMD
+
+__attribute__((target("sse4.1")))
+static void AccumulateChi2SSE41(const int* hist1, double nbPixels1,
+                                const int* hist2, double nbPixels2,
+                                int nbBins, double& dist, double& nbNonZero)
+{
+    const __m128d n1 = _mm_set1_pd(nbPixels1);
+    const __m128d n2 = _mm_set1_pd(nbPixels2);
+    const __m128d zero = _mm_setzero_pd();
+
+    int i = 0;
+    double terms[2];
+    for( ; i+2 <= nbBins; i += 2 )
+    {
+        __m128i c1 = _mm_loadl_epi64((const __m128i*)(hist1+i));
+        __m128i c2 = _mm_loadl_epi64((const __m128i*)(hist2+i));
+        //LTP histograms are sparse: skip the divisions of empty bins
+        __m128i any = _mm_or_si128(c1, c2);
+        if( _mm_testz_si128(any, any) ) continue;
+        __m128d h1 = _mm_div_pd(_mm_cvtepi32_pd(c1), n1);
+        __m128d h2 = _mm_div_pd(_mm_cvtepi32_pd(c2), n2);
+        __m128d sum = _mm_add_pd(h1, h2);
+        int mask = _mm_movemask_pd(_mm_cmpgt_pd(sum, zero));
+        __m128d d = _mm_sub_pd(h1, h2);
+        _mm_storeu_pd(terms, _mm_div_pd(_mm_mul_pd(d, d), sum));
+        //empty bins give 0/0: only the terms of non empty bins are added, in bin order
+        if( mask & 1 ) dist += terms[0];
+        if( mask & 2 ) dist += terms[1];
+        nbNonZero += __builtin_popcount(mask);
+    }
+    AccumulateChi2Scalar(hist1, nbPixels1, hist2, nbPixels2, i, nbBins, dist, nbNonZero);
+}
+
+__attribute__((target("avx2")))
+static void AccumulateChi2AVX2(const int* hist1, double nbPixels1,
+                               const int* hist2, double nbPixels2,
+                               int nbBins, double& dist, double& nbNonZero)
+{
+    const __m256d n1 = _mm256_set1_pd(nbPixels1);
+    const __m256d n2 = _mm256_set1_pd(nbPixels2);
+    const __m256d zero = _mm256_setzero_pd();
+
+    int i = 0;
+    double terms[4];
+    for( ; i+4 <= nbBins; i += 4 )
+    {
+        __m128i c1 = _mm_loadu_si128((const __m128i*)(hist1+i));
+        __m128i c2 = _mm_loadu_si128((const __m128i*)(hist2+i));
+        //LTP histograms are sparse: skip the divisions of empty bins
+        __m128i any = _mm_or_si128(c1, c2);
+        if( _mm_testz_si128(any, any) ) continue;
+        __m256d h1 = _mm256_div_pd(_mm256_cvtepi32_pd(c1), n1);
+        __m256d h2 = _mm256_div_pd(_mm256_cvtepi32_pd(c2), n2);
+        __m256d sum = _mm256_add_pd(h1, h2);
+        int mask = _mm256_movemask_pd(_mm256_cmp_pd(sum, zero, _CMP_GT_OQ));
+        __m256d d = _mm256_sub_pd(h1, h2);
+        _mm256_storeu_pd(terms, _mm256_div_pd(_mm256_mul_pd(d, d), sum));
+        nbNonZero += __builtin_popcount(mask);
+        //empty bins give 0/0: only the terms of non empty bins are added, in bin order
+        while( mask )
+        {
+            dist += terms[__builtin_ctz(mask)];
+            mask &= mask - 1;
+        }
+    }
+    AccumulateChi2Scalar(hist1, nbPixels1, hist2, nbPixels2, i, nbBins, dist, nbNonZero);
+}
+
+#endif
+
+void AccumulateChi2(SimdLevel level,
+                    const int* hist1, double nbPixels1,
+                    const int* hist2, double nbPixels2,
+                    int nbBins, double& dist, double& nbNonZero)
+{
+#ifdef ASARI_X86_SIMD
+    if( level == SIMD_AVX2 )
+    {
+        AccumulateChi2AVX2(hist1, nbPixels1, hist2, nbPixels2, nbBins, dist, nbNonZero);
+        return;
+    }
+    if( level == SIMD_SSE41 )
+    {
+        AccumulateChi2SSE41(hist1, nbPixels1, hist2, nbPixels2, nbBins, dist, nbNonZero);
+        return;
+    }
+#endif
+    AccumulateChi2Scalar(hist1, nbPixels1, hist2, nbPixels2, 0, nbBins, dist, nbNonZero);
+}
@@ -0,0 +1,86 @@
+#include "labconverter.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+
+LabConverter::LabConverter(LabConversionMode mode) : mode(mode)
+{
+    for(int i=0;i<256;i++){
+        double c=i/255.0;
+        if(c <= 0.04045)	linear[i] = c/12.92;
+        else				linear[i] = pow((c+0.055)/1.055,2.4);
+    }
+}
+
+double LabConverter::cubeRoot(double x) const{
+    if(mode==LAB_EXACT) return pow(x, 1.0/3.0);
+
+    //divide the exponent by 3 on the bit pattern: about 5% error
+    uint64_t i;
+    memcpy(&i,&x,sizeof(double));
+    i = i/3 + 0x2A9F7893782DA1CEULL;
+    double y;
+    memcpy(&y,&i,sizeof(double));
+    //each Halley step triples the number of correct digits
+    double y3=y*y*y;
+    y = y*(y3+2.0*x)/(2.0*y3+x);
+    y3=y*y*y;
+    y = y*(y3+2.0*x)/(2.0*y3+x);
+    return y;
+}
+
+void LabConverter::convert(int sR, int sG, int sB, double& lval, double& aval, double& bval) const{
+    double r = linear[sR];
+    double g = linear[sG];
+    double b = linear[sB];
+
+    double X = r*0.4124564 + g*0.3575761 + b*0.1804375;
+    double Y = r*0.2126729 + g*0.7151522 + b*0.0721750;
+    double Z = r*0.0193339 + g*0.1191920 + b*0.9503041;
+
+    const double epsilon = 0.008856;	//actual CIE standard
+    const double kappa   = 903.3;		//actual CIE standard
+
+    double xr = X/0.950456;	//reference white
+    double yr = Y/1.0;		//reference white
+    double zr = Z/1.088754;	//reference white
+
+    double fx, fy, fz;
+    if(xr > epsilon)	fx = cubeRoot(xr);
+    else				fx = (kappa*xr + 16.0)/116.0;
+    if(yr > epsilon)	fy = cubeRoot(yr);
+    else				fy = (kappa*yr + 16.0)/116.0;
+    if(zr > epsilon)	fz = cubeRoot(zr);
+    else				fz = (kappa*zr + 16.0)/116.0;
+
+    lval = 116.0*fy-16.0;
+    aval = 500.0*(fx-fy);
+    bval = 200.0*(fy-fz);
+}
+
+void LabConverter::convert(const unsigned int* ubuff, int sz, double* lvec, double* avec, double* bvec) const{
+    for( int j = 0; j < sz; j++ )
+    {
+        int r = (ubuff[j] >> 16) & 0xFF;
+        int g = (ubuff[j] >>  8) & 0xFF;
+        int b = (ubuff[j]      ) & 0xFF;
+
+        convert( r, g, b, lvec[j], avec[j], bvec[j] );
+    }
+}
+
+void LabConverter::convert(const unsigned int* ubuff, int sz, float* lab, int stride) const{
+    for( int j = 0; j < sz; j++ )
+    {
+        int r = (ubuff[j] >> 16) & 0xFF;
+        int g = (ubuff[j] >>  8) & 0xFF;
+        int b = (ubuff[j]      ) & 0xFF;
+
+        double lval, aval, bval;
+        convert( r, g, b, lval, aval, bval );
+        lab[j*stride] = lval;
+        lab[j*stride+1] = aval;
+        lab[j*stride+2] = bval;
+    }
+}
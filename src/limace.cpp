@@ -19,6 +19,14 @@
 #include <ctype.h>
 #include <stdarg.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define LIMACE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 
 
 /**
@@ -162,6 +170,44 @@ static int fMatWriteUC(FILE *Fid, unsigned char **I, int NbRow, int NbCol)
 }
 
 
+/**
+ * @brief fMatWriteRGB write three matrices of unsigned char elements as interleaved RGB triplets in a binary file
+ *
+ * each row is interleaved in a buffer and written with a single fwrite
+ * @param Fid[i] file descriptor
+ * @param R[i] red values
+ * @param G[i] green values
+ * @param B[i] blue values
+ * @param NbRow[i] number of rows
+ * @param NbCol[i] number of columns
+ * @return number of written pixels or -1 if not enough memory
+ */
+static int fMatWriteRGB(FILE *Fid, unsigned char **R, unsigned char **G, unsigned char **B, int NbRow, int NbCol)
+{
+    unsigned char *Row,*pRow;
+    int i,j;
+
+    Row=(unsigned char *)malloc(3*NbCol*sizeof(unsigned char));
+    if (Row==NULL) return -1;
+    for (i=0;i<NbRow;i++)
+    {
+        for (j=0,pRow=Row;j<NbCol;j++)
+        {
+            *pRow++=R[i][j];
+            *pRow++=G[i][j];
+            *pRow++=B[i][j];
+        }
+        if (fwrite(Row,sizeof(unsigned char),3*NbCol,Fid)!=((size_t)3*NbCol))
+        {
+            free(Row);
+            return i*NbCol;
+        }
+    }
+    free(Row);
+    return NbRow*NbCol;
+}
+
+
 /**
  * @brief MatCopyUC copy a matrix of unsigned char elements
  * @param Source[i] data which must be copied
@@ -1757,6 +1803,281 @@ static Image fImRead(FILE **pFid, const char FileName[])
 }
 
 
+/* Memory mapped binary pgm and ppm files */
+
+/**
+ * @struct sPnmMap limace.c
+ * @brief a binary pgm or ppm file mapped in memory
+ */
+struct sPnmMap
+{
+    ImageType TypeImage;
+    int NbRow;
+    int NbCol;
+    int MaxVal;
+    void *Base;                 /* start of the mapping */
+    size_t Size;                /* size of the mapping */
+    const unsigned char *Data;  /* first pixel, just after the header */
+};
+
+/**
+ * @brief MemGetC read next character of a buffer
+ *
+ * same as GetC: ignore comment starting with the character '#'
+ * the comment end with the line
+ * @param pCur[i/o] current position
+ * @param End[i] end of the buffer
+ * @param pCar[o] to store character
+ * @return 0 if end of buffer has been reached, 1 otherwise
+ */
+static int MemGetC(const unsigned char **pCur, const unsigned char *End, char *pCar)
+{
+    char c;
+
+    if (*pCur>=End) return 0;
+    c=(char)*(*pCur)++;
+    if (c=='#')
+    {
+        do
+        {
+            if (*pCur>=End) return 0;
+            c=(char)*(*pCur)++;
+        } while ((c!='\n') && (c!='\r'));
+    }
+    *pCar=c;
+    return 1;
+}
+
+/**
+ * @brief MemGetInt read next integer of a buffer
+ *
+ * same as GetInt: the character following the integer is consumed
+ * @param pCur[i/o] current position
+ * @param End[i] end of the buffer
+ * @param pInt[o] to store integer
+ * @return  0 if something wrong or if end of buffer has been reached, 1 otherwise
+ */
+static int MemGetInt(const unsigned char **pCur, const unsigned char *End, int *pInt)
+{
+    char c;
+    int i;
+
+    do
+    {
+        if (MemGetC(pCur,End,&c)==0) return 0;
+    } while ((c==' ') || (c=='\t') || (c=='\n') || (c=='\r'));
+    if ((c<'0') || (c>'9')) return 0;
+    i=0;
+    do
+    {
+        i=i*10+c-'0';
+        if (MemGetC(pCur,End,&c)==0) return 0;
+    } while ((c>='0') && (c<='9'));
+    *pInt=i;
+    return 1;
+}
+
+/**
+ * @brief PnmMapOpenAux map a binary pgm or ppm file without printing error messages
+ * @param FileName[i] image path
+ * @return the mapped file or NULL if something wrong
+ */
+static PnmMap PnmMapOpenAux(const char FileName[])
+{
+#ifdef LIMACE_MMAP
+    PnmMap Map;
+    struct stat Stat;
+    const unsigned char *Cur,*End;
+    void *Base;
+    size_t Size;
+    char Format;
+    int Fd,NbLig,NbCol,MaxVal,NbChannels;
+
+    Fd=open(FileName,O_RDONLY);
+    if (Fd<0) return NULL;
+    if ((fstat(Fd,&Stat)!=0)||(!S_ISREG(Stat.st_mode))||(Stat.st_size==0))
+    {
+        close(Fd);
+        return NULL;
+    }
+    Size=(size_t)Stat.st_size;
+    Base=mmap(NULL,Size,PROT_READ,MAP_PRIVATE,Fd,0);
+    close(Fd);
+    if (Base==MAP_FAILED) return NULL;
+
+    Cur=(const unsigned char *)Base;
+    End=Cur+Size;
+    if ((MemGetC(&Cur,End,&Format)==0)||(Format!='P')||
+            (MemGetC(&Cur,End,&Format)==0)||((Format!='5')&&(Format!='6'))||
+            (MemGetInt(&Cur,End,&NbCol)==0)||(MemGetInt(&Cur,End,&NbLig)==0)||
+            (MemGetInt(&Cur,End,&MaxVal)==0)||(MaxVal<1)||(MaxVal>255)||
+            (NbCol<=0)||(NbLig<=0))
+    {
+        munmap(Base,Size);
+        return NULL;
+    }
+    NbChannels=(Format=='5')?1:3;
+    if ((size_t)(End-Cur)/NbChannels/NbCol<(size_t)NbLig)
+    {
+        munmap(Base,Size);
+        return NULL;
+    }
+    Map=(PnmMap)malloc(sizeof(struct sPnmMap));
+    if (Map==NULL)
+    {
+        munmap(Base,Size);
+        return NULL;
+    }
+#ifdef MADV_SEQUENTIAL
+    madvise(Base,Size,MADV_SEQUENTIAL);
+#endif
+    Map->TypeImage=(Format=='5')?GrayLevel:Col0r;
+    Map->NbRow=NbLig;
+    Map->NbCol=NbCol;
+    Map->MaxVal=MaxVal;
+    Map->Base=Base;
+    Map->Size=Size;
+    Map->Data=Cur;
+    return Map;
+#else
+    (void)FileName;
+    return NULL;
+#endif
+}
+
+/**
+ * @brief PnmMapOpen map a binary pgm or ppm file in memory and parse its header
+ *
+ * the pixels are not copied: they are read in place in the mapped file
+ * @param FileName[i] image path
+ * @return the mapped file or NULL if it is not a binary pgm or ppm with maxval <= 255,
+ * or if memory mapping is not available
+ */
+PnmMap PnmMapOpen(const char FileName[])
+{
+    PnmMap Map;
+
+    Map=PnmMapOpenAux(FileName);
+    if (Map==NULL)
+        LimError("PnmMapOpen","%s: unable to map a binary pgm or ppm file",FileName);
+    return Map;
+}
+
+/**
+ * @brief PnmMapType image type of a mapped file (GrayLevel for P5, Col0r for P6)
+ * @param Map[i] mapped file
+ * @return image type
+ */
+ImageType PnmMapType(PnmMap Map)
+{
+    return Map->TypeImage;
+}
+
+/**
+ * @brief PnmMapNbRow number of rows of a mapped file
+ * @param Map[i] mapped file
+ * @return number of rows
+ */
+int PnmMapNbRow(PnmMap Map)
+{
+    return Map->NbRow;
+}
+
+/**
+ * @brief PnmMapNbCol number of columns of a mapped file
+ * @param Map[i] mapped file
+ * @return number of columns
+ */
+int PnmMapNbCol(PnmMap Map)
+{
+    return Map->NbCol;
+}
+
+/**
+ * @brief PnmMapMaxVal maximal value declared in the header of a mapped file
+ * @param Map[i] mapped file
+ * @return maxval
+ */
+int PnmMapMaxVal(PnmMap Map)
+{
+    return Map->MaxVal;
+}
+
+/**
+ * @brief PnmMapData pixel payload of a mapped file
+ *
+ * row major, one byte per pixel for P5 and interleaved RGB triplets for P6
+ * @param Map[i] mapped file
+ * @return pixels, valid until PnmMapClose
+ */
+const unsigned char *PnmMapData(PnmMap Map)
+{
+    return Map->Data;
+}
+
+/**
+ * @brief PnmMapClose unmap a file
+ * @param pMap[i] mapped file
+ */
+void PnmMapClose(PnmMap *pMap)
+{
+    if (*pMap!=NULL)
+    {
+#ifdef LIMACE_MMAP
+        munmap((*pMap)->Base,(*pMap)->Size);
+#endif
+        free(*pMap);
+        *pMap=NULL;
+    }
+}
+
+/**
+ * @brief PnmMap2Image create an image from a mapped file
+ *
+ * pixels are copied (and deinterleaved for ppm) from the mapping to the image
+ * in a single pass, rescaling values as fImRead does when maxval is not 255
+ * @param Map[i] mapped file
+ * @return an image or NULL if not enough memory
+ */
+static Image PnmMap2Image(PnmMap Map)
+{
+    Image Im;
+    unsigned char Lut[256],*I,*R,*G,*B,*Fin;
+    const unsigned char *pD;
+    double Coeff;
+    int v;
+
+    Im=ImAlloc(Map->TypeImage,Map->NbRow,Map->NbCol);
+    if (Im==NULL) return NULL;
+    Coeff=255.0/(double)Map->MaxVal;
+    for (v=0;v<256;v++)
+        Lut[v]=(Map->MaxVal==255)?(unsigned char)v:(unsigned char)floor(Coeff*v+0.5);
+    pD=Map->Data;
+    if (Map->TypeImage==GrayLevel)
+    {
+        I=*ImGetI(Im);
+        Fin=I+Map->NbRow*Map->NbCol;
+        if (Map->MaxVal==255) memcpy(I,pD,Map->NbRow*Map->NbCol);
+        else while (I<Fin) *I++=Lut[*pD++];
+    }
+    else
+    {
+        R=*ImGetR(Im);
+        G=*ImGetG(Im);
+        B=*ImGetB(Im);
+        Fin=R+Map->NbRow*Map->NbCol;
+        while (R<Fin)
+        {
+            *R++=Lut[pD[0]];
+            *G++=Lut[pD[1]];
+            *B++=Lut[pD[2]];
+            pD+=3;
+        }
+    }
+    return Im;
+}
+
+
 /**
  * @brief ImRead read a ppm, pgm or pbm image
  * @param FileName[i] image path
@@ -1765,6 +2086,7 @@ static Image fImRead(FILE **pFid, const char FileName[])
 Image ImRead(const char FileName[])
 {
     Image Im;
+    PnmMap Map;
     FILE *Fid;
 
     if (FileName[0]=='\0')
@@ -1774,6 +2096,15 @@ Image ImRead(const char FileName[])
     }
     else
     {
+        /* binary pgm and ppm are read in place, other files with stdio */
+        Map=PnmMapOpenAux(FileName);
+        if (Map!=NULL)
+        {
+            Im=PnmMap2Image(Map);
+            PnmMapClose(&Map);
+            if (Im==NULL) LimError("ImRead","not enough memory");
+            return Im;
+        }
         Fid=fopen(FileName,"rb");
         if (Fid==NULL)
         {
@@ -1802,7 +2133,7 @@ void ImWrite(Image Im, const char FileName[])
     FILE *Fid;
     ImageType Type;
     int i,j,k,NbEcrits,NbLig,NbCol;
-    unsigned char **I,**R,**G,**B,Byte=0;
+    unsigned char **I,Byte=0;
 
     if (Im==NULL)
     {
@@ -1922,31 +2253,19 @@ void ImWrite(Image Im, const char FileName[])
       return;
       }
       }*/
-        R=ImGetR(Im);
-        G=ImGetG(Im);
-        B=ImGetB(Im);
-        for (i=0;i<NbLig;i++)
-            for (j=0;j<NbCol;j++)
-            {
-                if (putc(R[i][j],Fid)==EOF)
-                {
-                    LimError("ImWrite","error while writing %s",FileName);
-                    if (FileName[0]!='\0') fclose(Fid);
-                    return;
-                }
-                if (putc(G[i][j],Fid)==EOF)
-                {
-                    LimError("ImWrite","error while writing %s",FileName);
-                    if (FileName[0]!='\0') fclose(Fid);
-                    return;
-                }
-                if (putc(B[i][j],Fid)==EOF)
-                {
-                    LimError("ImWrite","error while writing %s",FileName);
-                    if (FileName[0]!='\0') fclose(Fid);
-                    return;
-                }
-            }
+        NbEcrits=fMatWriteRGB(Fid,ImGetR(Im),ImGetG(Im),ImGetB(Im),NbLig,NbCol);
+        if (NbEcrits<0)
+        {
+            LimError("ImWrite","not enough memory");
+            if (FileName[0]!='\0') fclose(Fid);
+            return;
+        }
+        if (NbEcrits!=(NbLig*NbCol))
+        {
+            LimError("ImWrite","error while writing %s",FileName);
+            if (FileName[0]!='\0') fclose(Fid);
+            return;
+        }
         break;
     }
 
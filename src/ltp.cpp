@@ -1,4 +1,5 @@
 #include "ltp.h"
+#include "ltpkernel.h"
 #include <iostream>
 #include <assert.h>
 using namespace std;
@@ -8,144 +9,89 @@ using namespace std;
 
 vector<LTP_DATA>  LTP::computeLTP(Image image){
 
+    LTPImage packed;
+    computeLTP(image,packed);
+
     //Result
-    vector<LTP_DATA> ltps;
+    vector<LTP_DATA> ltps(packed.width*packed.height);
+    for(unsigned int i=0;i<ltps.size();i++){
+        ltps[i].ltpN=packed.codesN[i];
+        ltps[i].ltpP=packed.codesP[i];
+        ltps[i].homogeneous=packed.isHomogeneous(i);
+    }
+    return ltps;
+}
+
+void LTP::computeLTP(Image image,LTPImage& ltps){
+    int widthIm=ImNbCol(image);
+    ltps.resize(widthIm,ImNbRow(image));
+    computeLTP(image,0,ltps.height,[&](int y,const unsigned char* codesP,const unsigned char* codesN,const unsigned char* homogeneous){
+        int i=y*widthIm;
+        copy(codesP,codesP+widthIm,&ltps.codesP[i]);
+        copy(codesN,codesN+widthIm,&ltps.codesN[i]);
+        for(int x=0;x<widthIm;x++,i++){
+            if(homogeneous[x]) ltps.homogeneous[i>>3]|=1<<(i&7);
+        }
+    });
+}
+
+/**
+ * @brief grayRow convert a row to grey levels, extending it by one pixel on each side
+ * @param[in] red
+ * @param[in] green
+ * @param[in] blue
+ * @param[in] width
+ * @param[out] gray padded row of width+2 grey levels
+ */
+static void grayRow(const unsigned char* red,const unsigned char* green,const unsigned char* blue,int width,unsigned char* gray){
+    for(int x=0;x<width;x++){
+        gray[x+1]=0.2126*red[x] + 0.7152*green[x] + 0.0722*blue[x];
+    }
+    gray[0]=gray[1];
+    gray[width+1]=gray[width];
+}
+
+void LTP::computeLTP(Image image,int y1,int y2,const LTPRowConsumer& consumer) const{
 
     //Get image properties
     int heightIm=ImNbRow(image);
     int widthIm=ImNbCol(image);
+    assert(0<=y1 && y1<=y2 && y2<=heightIm);
+    if(y1==y2) return;
 
     //Get pixels colors
     unsigned char** red=ImGetR(image);
     unsigned char** green=ImGetG(image);
     unsigned char** blue=ImGetB(image);
 
+    //a LTP is homogeneous when enough neighbours are similar
+    unsigned char homogeneous[256];
+    for(int mask=0;mask<256;mask++){
+        homogeneous[mask]=__builtin_popcount(mask)>=thresholdHomogeneous;
+    }
 
-    //Create a more larger image to compute LTP on the all original image
-    int heightLTP=heightIm+2;
+    //ring of three padded grey rows: row v is in slot (v+1)%3, rows outside the image
+    //repeat the border
     int widthLTP=widthIm+2;
-    vector<int> data;
-    //copy image
-    //and extand border
-    for(int y=0;y<heightLTP;y++){
-        for(int x=0;x<widthLTP;x++){
-            int u=min(max(x-1,0),widthIm-1);
-            int v=min(max(y-1,0),heightIm-1);
-            int gray=0.2126*red[v][u] + 0.7152*green[v][u] + 0.0722*blue[v][u];
-            data.push_back(gray);
-        }
+    vector<unsigned char> ring(3*widthLTP);
+    for(int v=y1-1;v<=y1;v++){
+        int u=min(max(v,0),heightIm-1);
+        grayRow(red[u],green[u],blue[u],widthIm,&ring[((v+1)%3)*widthLTP]);
     }
 
-    for(int y=1;y<heightLTP-1;y++){
-        for(int x=1;x<widthLTP-1;x++){
-            int p1=data[x+y*widthLTP];
-            //positiv ltp
-            int ltpP=0;
-            //negativ ltp
-            int ltpN=0;
-
-            vector<int> signs;
-            signs.assign(8,1);
-            //north
-            int s=sign(p1,data[x+(y-1)*widthLTP]);
-            if(s==0){
-                signs.push_back(0);
-            }else if(s==1){
-                ltpP+=1;
-            }else{
-                ltpN+=1;
-            }
-            //north-east
-            s=sign(p1,data[(x+1)+(y-1)*widthLTP]);
-            if(s==0){
-                signs.push_back(0);
-            }else if(s==1){
-                ltpP+=2;
-            }else{
-                ltpP+=0;
-            }
-            //east
-            s=sign(p1,data[(x+1)+y*widthLTP]);
-            if(s==0){
-                signs.push_back(0);
-            }else if(s==1){
-                ltpP+=4;
-            }else{
-                ltpN+=4;
-            }
-            //south-east
-            s=sign(p1,data[(x+1)+(y+1)*widthLTP]);
-            if(s==0){
-                signs.push_back(0);
-            }else if(s==1){
-                ltpP+=8;
-            }else{
-                ltpN+=8;
-            }
-            //south
-            s=sign(p1,data[x+(y+1)*widthLTP]);
-            if(s==0){
-                signs.push_back(0);
-            }else if(s==1){
-                ltpP+=16;
-            }else{
-                ltpN+=16;
-            }
-            //south-west
-            s=sign(p1,data[(x-1)+(y+1)*widthLTP]);
-            if(s==0){
-                signs.push_back(0);
-            }else if(s==1){
-                ltpP+=32;
-            }else{
-                ltpN+=32;
-            }
-            //west
-            s=sign(p1,data[(x-1)+y*widthLTP]);
-            if(s==0){
-                signs.push_back(0);
-            }else if(s==1){
-                ltpP+=64;
-            }else{
-                ltpN+=64;
-            }
-            //north-west
-            s=sign(p1,data[(x-1)+(y-1)*widthLTP]);
-            if(s==0){
-                signs.push_back(0);
-            }else if(s==1){
-                ltpP+=128;
-            }else{
-                ltpN+=128;
-            }
-
-
-            //count number of consecutive similar pixels
-            int nbSim=0;
-            for(int i=0;i<signs.size();i++){
-                if(signs[i]==0){
-                    //increment number of consecutive similar pixels
-                    nbSim++;
-                }else{
-                    //reset number of consecutive similar pixels;
-                    nbSim=0;
-                }
-            }
-            if(nbSim<signs.size() && nbSim>0){
-                int i=0;
-                while(signs[i]==0){
-                    nbSim++;
-                    i++;
-                }
-            }
-
-            LTP_DATA res;
-            res.ltpN=ltpN;
-            res.ltpP=ltpP;
-            res.homogeneous=nbSim>=thresholdHomogeneous;
-            ltps.push_back(res);
+    vector<unsigned char> codes(3*widthIm);
+    unsigned char* codesP=&codes[0];
+    unsigned char* codesN=&codes[widthIm];
+    unsigned char* similar=&codes[2*widthIm];
+    SimdLevel level=bestSimdLevel();
+    for(int y=y1;y<y2;y++){
+        int v=min(y+1,heightIm-1);
+        grayRow(red[v],green[v],blue[v],widthIm,&ring[((y+2)%3)*widthLTP]);
+        ComputeLTPRow(level,&ring[(y%3)*widthLTP],&ring[((y+1)%3)*widthLTP],&ring[((y+2)%3)*widthLTP],
+                      widthIm,thresholdLTP,codesP,codesN,similar);
+        for(int x=0;x<widthIm;x++){
+            similar[x]=homogeneous[similar[x]];
         }
+        consumer(y,codesP,codesN,similar);
     }
-
-    return ltps;
 }
@@ -0,0 +1,124 @@
+#include "ltphistogram.h"
+#include "chi2kernel.h"
+
+#include <algorithm>
+#include <assert.h>
+
+static bool lowerBin(const LTPBin& b, int bin){
+    return b.bin < bin;
+}
+
+void LTPHistogram::toDense(){
+    dense.assign(nbBins,0);
+    for(unsigned int i=0;i<sparse.size();i++){
+        dense[sparse[i].bin]=sparse[i].count;
+    }
+    vector<LTPBin>().swap(sparse);
+}
+
+void LTPHistogram::add(int bin, int count){
+    assert(bin>=0 && bin<nbBins);
+    if(isDense()){
+        dense[bin]+=count;
+        return;
+    }
+    vector<LTPBin>::iterator it=lower_bound(sparse.begin(),sparse.end(),bin,lowerBin);
+    if(it!=sparse.end() && it->bin==bin){
+        it->count+=count;
+    }else{
+        LTPBin b={bin,count};
+        sparse.insert(it,b);
+        if(int(sparse.size())>maxSparseBins) toDense();
+    }
+}
+
+void LTPHistogram::merge(const LTPHistogram& other){
+    if(other.isDense()){
+        if(!isDense()) toDense();
+        for(int i=0;i<nbBins;i++){
+            dense[i]+=other.dense[i];
+        }
+    }else if(isDense()){
+        for(unsigned int i=0;i<other.sparse.size();i++){
+            dense[other.sparse[i].bin]+=other.sparse[i].count;
+        }
+    }else{
+        //union of two sorted lists
+        vector<LTPBin> merged;
+        merged.reserve(sparse.size()+other.sparse.size());
+        unsigned int i=0,j=0;
+        while(i<sparse.size() || j<other.sparse.size()){
+            if(j==other.sparse.size() || (i<sparse.size() && sparse[i].bin<other.sparse[j].bin)){
+                merged.push_back(sparse[i++]);
+            }else if(i==sparse.size() || other.sparse[j].bin<sparse[i].bin){
+                merged.push_back(other.sparse[j++]);
+            }else{
+                LTPBin b={sparse[i].bin,sparse[i].count+other.sparse[j].count};
+                merged.push_back(b);
+                i++;
+                j++;
+            }
+        }
+        sparse.swap(merged);
+        if(int(sparse.size())>maxSparseBins) toDense();
+    }
+}
+
+int LTPHistogram::count(int bin) const{
+    if(isDense()) return dense[bin];
+    vector<LTPBin>::const_iterator it=lower_bound(sparse.begin(),sparse.end(),bin,lowerBin);
+    return (it!=sparse.end() && it->bin==bin) ? it->count : 0;
+}
+
+void LTPHistogram::clear(){
+    vector<int>().swap(dense);
+    vector<LTPBin>().swap(sparse);
+}
+
+/**
+ * @brief addChi2Term same operations as the scalar AccumulateChi2 on one bin
+ */
+static inline void addChi2Term(int count1, double nbPixels1, int count2, double nbPixels2,
+                               double& dist, double& nbNonZero){
+    double h1=count1/nbPixels1;
+    double h2=count2/nbPixels2;
+    if(h1>0 || h2>0){
+        double d=h1-h2;
+        dist+=d*d/(h1+h2);
+        nbNonZero++;
+    }
+}
+
+void LTPHistogram::accumulateChi2(SimdLevel level,
+                                  const LTPHistogram& hist1, double nbPixels1,
+                                  const LTPHistogram& hist2, double nbPixels2,
+                                  double& dist, double& nbNonZero){
+    if(hist1.isDense() && hist2.isDense()){
+        AccumulateChi2(level,hist1.dense.data(),nbPixels1,hist2.dense.data(),nbPixels2,nbBins,dist,nbNonZero);
+    }else if(hist1.isDense() || hist2.isDense()){
+        const vector<LTPBin>& sparse=hist1.isDense() ? hist2.sparse : hist1.sparse;
+        const vector<int>& dense=hist1.isDense() ? hist1.dense : hist2.dense;
+        unsigned int j=0;
+        for(int i=0;i<nbBins;i++){
+            int countSparse=0;
+            if(j<sparse.size() && sparse[j].bin==i) countSparse=sparse[j++].count;
+            if(!dense[i] && !countSparse) continue;
+            if(hist1.isDense()) addChi2Term(dense[i],nbPixels1,countSparse,nbPixels2,dist,nbNonZero);
+            else addChi2Term(countSparse,nbPixels1,dense[i],nbPixels2,dist,nbNonZero);
+        }
+    }else{
+        //both sparse: visit the union of the non empty bins in code order
+        const vector<LTPBin>& s1=hist1.sparse;
+        const vector<LTPBin>& s2=hist2.sparse;
+        unsigned int i=0,j=0;
+        while(i<s1.size() || j<s2.size()){
+            if(j==s2.size() || (i<s1.size() && s1[i].bin<s2[j].bin)){
+                addChi2Term(s1[i++].count,nbPixels1,0,nbPixels2,dist,nbNonZero);
+            }else if(i==s1.size() || s2[j].bin<s1[i].bin){
+                addChi2Term(0,nbPixels1,s2[j++].count,nbPixels2,dist,nbNonZero);
+            }else{
+                addChi2Term(s1[i++].count,nbPixels1,s2[j++].count,nbPixels2,dist,nbNonZero);
+            }
+        }
+    }
+}
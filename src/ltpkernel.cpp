@@ -0,0 +1,120 @@
+#include "ltpkernel.h"
+
+#include <cstdlib>
+
+#ifdef ASARI_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief neighbour of each bit: row (0 above, 1 same, 2 below) and column offset
+ */
+static const int neighbourRow[8]={0,0,1,2,2,2,1,0};
+static const int neighbourColumn[8]={0,1,1,1,0,-1,-1,-1};
+/**
+ * @brief bits of codesN: the north-east comparison never sets its bit
+ */
+static const int negativeBits=0xFF & ~2;
+
+static void ComputeLTPRowScalar(const unsigned char* rows[3], int x1, int width, int threshold,
+                                unsigned char* codesP, unsigned char* codesN, unsigned char* similar)
+{
+    for( int x = x1; x < width; x++ )
+    {
+        int p = rows[1][x+1];
+        int ltpP = 0, ltpN = 0, sim = 0;
+        for( int n = 0; n < 8; n++ )
+        {
+            int q = rows[neighbourRow[n]][x+1+neighbourColumn[n]];
+            if( abs(p - q) < threshold ) sim |= 1 << n;
+            else if( p < q ) ltpN |= 1 << n;
+            else ltpP |= 1 << n;
+        }
+        codesP[x] = ltpP;
+        codesN[x] = ltpN & negativeBits;
+        similar[x] = sim;
+    }
+}
+
+#ifdef ASARI_X86_SIMD
+
+__attribute__((target("sse4.1")))
+static void ComputeLTPRowSSE41(const unsigned char* rows[3], int width, int threshold,
+                               unsigned char* codesP, unsigned char* codesN, unsigned char* similar)
+{
+    const __m128i thr = _mm_set1_epi8((char)threshold);
+    int x = 0;
+    for( ; x+16 <= width; x += 16 )
+    {
+        __m128i p = _mm_loadu_si128((const __m128i*)(rows[1]+x+1));
+        __m128i ltpP = _mm_setzero_si128(), ltpN = _mm_setzero_si128(), sim = _mm_setzero_si128();
+        for( int n = 0; n < 8; n++ )
+        {
+            __m128i q = _mm_loadu_si128((const __m128i*)(rows[neighbourRow[n]]+x+1+neighbourColumn[n]));
+            __m128i bit = _mm_set1_epi8((char)(1 << n));
+            //unsigned |p-q| >= threshold, and p < q
+            __m128i diff = _mm_or_si128(_mm_subs_epu8(p, q), _mm_subs_epu8(q, p));
+            __m128i different = _mm_cmpeq_epi8(_mm_max_epu8(diff, thr), diff);
+            __m128i greaterEqual = _mm_cmpeq_epi8(_mm_max_epu8(p, q), p);
+            sim = _mm_or_si128(sim, _mm_andnot_si128(different, bit));
+            ltpP = _mm_or_si128(ltpP, _mm_and_si128(_mm_and_si128(different, greaterEqual), bit));
+            ltpN = _mm_or_si128(ltpN, _mm_and_si128(_mm_andnot_si128(greaterEqual, different), bit));
+        }
+        _mm_storeu_si128((__m128i*)(codesP+x), ltpP);
+        _mm_storeu_si128((__m128i*)(codesN+x), _mm_and_si128(ltpN, _mm_set1_epi8((char)negativeBits)));
+        _mm_storeu_si128((__m128i*)(similar+x), sim);
+    }
+    ComputeLTPRowScalar(rows, x, width, threshold, codesP, codesN, similar);
+}
+
+__attribute__((target("avx2")))
+static void ComputeLTPRowAVX2(const unsigned char* rows[3], int width, int threshold,
+                              unsigned char* codesP, unsigned char* codesN, unsigned char* similar)
+{
+    const __m256i thr = _mm256_set1_epi8((char)threshold);
+    int x = 0;
+    for( ; x+32 <= width; x += 32 )
+    {
+        __m256i p = _mm256_loadu_si256((const __m256i*)(rows[1]+x+1));
+        __m256i ltpP = _mm256_setzero_si256(), ltpN = _mm256_setzero_si256(), sim = _mm256_setzero_si256();
+        for( int n = 0; n < 8; n++ )
+        {
+            __m256i q = _mm256_loadu_si256((const __m256i*)(rows[neighbourRow[n]]+x+1+neighbourColumn[n]));
+            __m256i bit = _mm256_set1_epi8((char)(1 << n));
+            //unsigned |p-q| >= threshold, and p < q
+            __m256i diff = _mm256_or_si256(_mm256_subs_epu8(p, q), _mm256_subs_epu8(q, p));
+            __m256i different = _mm256_cmpeq_epi8(_mm256_max_epu8(diff, thr), diff);
+            __m256i greaterEqual = _mm256_cmpeq_epi8(_mm256_max_epu8(p, q), p);
+            sim = _mm256_or_si256(sim, _mm256_andnot_si256(different, bit));
+            ltpP = _mm256_or_si256(ltpP, _mm256_and_si256(_mm256_and_si256(different, greaterEqual), bit));
+            ltpN = _mm256_or_si256(ltpN, _mm256_and_si256(_mm256_andnot_si256(greaterEqual, different), bit));
+        }
+        _mm256_storeu_si256((__m256i*)(codesP+x), ltpP);
+        _mm256_storeu_si256((__m256i*)(codesN+x), _mm256_and_si256(ltpN, _mm256_set1_epi8((char)negativeBits)));
+        _mm256_storeu_si256((__m256i*)(similar+x), sim);
+    }
+    ComputeLTPRowScalar(rows, x, width, threshold, codesP, codesN, similar);
+}
+
+#endif
+
+void ComputeLTPRow(SimdLevel level,
+                   const unsigned char* above, const unsigned char* row, const unsigned char* below,
+                   int width, int threshold,
+                   unsigned char* codesP, unsigned char* codesN, unsigned char* similar)
+{
+    const unsigned char* rows[3]={above,row,below};
+#ifdef ASARI_X86_SIMD
+    if( level == SIMD_AVX2 )
+    {
+        ComputeLTPRowAVX2(rows, width, threshold, codesP, codesN, similar);
+        return;
+    }
+    if( level == SIMD_SSE41 )
+    {
+        ComputeLTPRowSSE41(rows, width, threshold, codesP, codesN, similar);
+        return;
+    }
+#endif
+    ComputeLTPRowScalar(rows, 0, width, threshold, codesP, codesN, similar);
+}
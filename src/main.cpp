@@ -9,9 +9,11 @@ using namespace std;
 int main(int argc, char *argv[])
 {
 
-    if(argc !=3 ){
+    bool labelsOnly=argc==4 && string(argv[3])=="-labels";
+    if(argc !=3 && !labelsOnly){
         cerr << "Wrong parameters number" <<endl;
-        cerr << argv[0] << ": imagePath resPath"<<endl;
+        cerr << argv[0] << ": imagePath resPath [-labels]"<<endl;
+        cerr << "-labels: save the label of each pixel (32 bits integers, row by row) instead of boundaries" << endl;
         return -1;
     }
 
@@ -25,6 +27,15 @@ int main(int argc, char *argv[])
 
     //oversegment
     Parameters param;
+    if(labelsOnly){
+        //no result image: labels are written in our buffer
+        vector<int> labels(ImNbRow(image)*ImNbCol(image));
+        cout << Asari::computeLabels(param,image,labels.data()) << " superpixels" << endl;
+        ofstream res(argv[2],ios::binary);
+        res.write((const char*)labels.data(),labels.size()*sizeof(int));
+        ImFree(&image);
+        return 0;
+    }
     Asari asari(param,image);
     asari.compute();
     //display number of superpixels
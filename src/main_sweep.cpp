@@ -0,0 +1,82 @@
+#include "sweep.h"
+#include "limace.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+/**
+ * @brief parseList read comma separated values
+ * @param text
+ * @return values
+ */
+static vector<double> parseList(const char* text){
+    vector<double> values;
+    stringstream stream(text);
+    string value;
+    while(getline(stream,value,',')){
+        values.push_back(atof(value.c_str()));
+    }
+    return values;
+}
+
+int main(int argc, char *argv[])
+{
+
+    if(argc <6 ){
+        cerr << "Wrong parameters number" <<endl;
+        cerr << argv[0] << ": resDir similarityThresholds regularityParams spUnTexturedThresholds imagePath..."<<endl;
+        cerr << "thresholds and parameters are comma separated lists, every combination is computed" << endl;
+        return -1;
+    }
+    string resDir=argv[1];
+    vector<double> similarityThresholds=parseList(argv[2]);
+    vector<double> regularityParams=parseList(argv[3]);
+    vector<double> spUnTexturedThresholds=parseList(argv[4]);
+
+    //every combination shares slic and LTP
+    vector<Parameters> configurations;
+    for(unsigned int i=0;i<similarityThresholds.size();i++){
+        for(unsigned int j=0;j<regularityParams.size();j++){
+            for(unsigned int k=0;k<spUnTexturedThresholds.size();k++){
+                Parameters param;
+                param.similarityThreshold=similarityThresholds[i];
+                param.regularityParam=regularityParams[j];
+                param.spUnTexturedThreshold=spUnTexturedThresholds[k];
+                configurations.push_back(param);
+            }
+        }
+    }
+
+    ofstream timings((resDir+"/timings.csv").c_str());
+    timings << "image,configuration,similarityThreshold,regularityParam,spUnTexturedThreshold,superpixels,initializationTime,mergingTime" << endl;
+    for(int a=5;a<argc;a++){
+        //load image
+        Image image=ImRead(argv[a]);
+        if(ImType(image)!=Col0r){
+            cerr << argv[a] << ": give a color image" << endl;
+            ImFree(&image);
+            continue;
+        }
+
+        //results are named after the image file
+        string name=argv[a];
+        name=name.substr(name.find_last_of('/')+1);
+        name=name.substr(0,name.find_last_of('.'));
+
+        vector<SweepResult> results=sweepParameters(image,configurations,true,0,resDir+"/"+name+"_");
+        for(unsigned int i=0;i<results.size();i++){
+            timings << name << "," << i << "," << results[i].param.similarityThreshold << "," << results[i].param.regularityParam
+                    << "," << results[i].param.spUnTexturedThreshold << "," << results[i].nbSuperpixels
+                    << "," << results[i].initializationTime << "," << results[i].mergingTime << endl;
+        }
+        cout << name << ": " << results.size() << " configurations" << endl;
+
+        // free memory
+        ImFree(&image);
+    }
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include "mergetree.h"
+
+#include <algorithm>
+#include <assert.h>
+
+void MergeTree::initialize(int nbLeaves){
+    this->nbLeaves=nbLeaves;
+    merges.clear();
+}
+
+void MergeTree::record(int absorbing, int absorbed, double distance){
+    assert(0<=absorbing && absorbing<nbLeaves && 0<=absorbed && absorbed<nbLeaves);
+    double height=merges.empty() ? distance : max(distance,merges.back().height);
+    MergeEvent event={absorbing,absorbed,distance,height};
+    merges.push_back(event);
+}
+
+int MergeTree::cut(int nbMerges, vector<int>& labels) const{
+    assert(0<=nbMerges && nbMerges<=(int)merges.size());
+    //an absorbed superpixel is never merged again: going backward, the absorbing one
+    //already knows its final region
+    vector<int> regions(nbLeaves);
+    for(int i=0;i<nbLeaves;i++){
+        regions[i]=i;
+    }
+    for(int i=nbMerges-1;i>=0;i--){
+        regions[merges[i].absorbed]=regions[merges[i].absorbing];
+    }
+
+    //number regions in ascending order
+    labels.assign(nbLeaves,-1);
+    int nbRegions=0;
+    for(int i=0;i<nbLeaves;i++){
+        if(regions[i]==i){
+            labels[i]=nbRegions;
+            nbRegions++;
+        }
+    }
+    for(int i=0;i<nbLeaves;i++){
+        labels[i]=labels[regions[i]];
+    }
+    return nbRegions;
+}
+
+int MergeTree::cutAtNbRegions(int nbRegions, vector<int>& labels) const{
+    int nbMerges=min(max(nbLeaves-nbRegions,0),(int)merges.size());
+    return cut(nbMerges,labels);
+}
+
+int MergeTree::cutAtDistance(double distance, vector<int>& labels) const{
+    //heights are sorted
+    vector<MergeEvent>::const_iterator last=upper_bound(merges.begin(),merges.end(),distance,
+                                                        [](double d,const MergeEvent& event){return d<event.height;});
+    int nbMerges=last-merges.begin();
+    return cut(nbMerges,labels);
+}
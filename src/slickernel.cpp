@@ -0,0 +1,230 @@
+#include "slickernel.h"
+
+#ifdef ASARI_X86_SIMD
+#include <immintrin.h>
+#endif
+
+static void AssignRowSegmentScalar(const double* lvec, const double* avec, const double* bvec,
+                                   double* distvec, int* klabels,
+                                   int width, int y, int x1, int x2,
+                                   const SLICSeed& seed, double invwt, int label)
+{
+    const double dy2 = (y - seed.y)*(y - seed.y);
+    for( int x = x1; x < x2; x++ )
+    {
+        int i = y*width + x;
+
+        double dist =	(lvec[i] - seed.l)*(lvec[i] - seed.l) +
+                        (avec[i] - seed.a)*(avec[i] - seed.a) +
+                        (bvec[i] - seed.b)*(bvec[i] - seed.b);
+
+        double distxy = (x - seed.x)*(x - seed.x) + dy2;
+
+        dist += distxy*invwt;
+        if( dist < distvec[i] )
+        {
+            distvec[i] = dist;
+            klabels[i] = label;
+        }
+    }
+}
+
+static void AssignRowSegmentScalar(LABDPixel* pixels, int* klabels,
+                                   int width, int y, int x1, int x2,
+                                   const SLICSeed& seed, float invwt, int label)
+{
+    const float sl = seed.l, sa = seed.a, sb = seed.b, sx = seed.x, sy = seed.y;
+    const float dy2 = (y - sy)*(y - sy);
+    for( int x = x1; x < x2; x++ )
+    {
+        LABDPixel& p = pixels[y*width + x];
+
+        float dist =	(p.l - sl)*(p.l - sl) +
+                        (p.a - sa)*(p.a - sa) +
+                        (p.b - sb)*(p.b - sb);
+
+        float distxy = (x - sx)*(x - sx) + dy2;
+
+        dist += distxy*invwt;
+        if( dist < p.dist )
+        {
+            p.dist = dist;
+            klabels[y*width + x] = label;
+        }
+    }
+}
+
+#ifdef ASARI_X86_SIMD
+
+__attribute__((target("sse4.1")))
+static void AssignRowSegmentSSE41(LABDPixel* pixels, int* klabels,
+                                  int width, int y, int x1, int x2,
+                                  const SLICSeed& seed, float invwt, int label)
+{
+    const float fsy = seed.y;
+    const __m128 sl = _mm_set1_ps(seed.l);
+    const __m128 sa = _mm_set1_ps(seed.a);
+    const __m128 sb = _mm_set1_ps(seed.b);
+    const __m128 sx = _mm_set1_ps(seed.x);
+    const __m128 dy2 = _mm_set1_ps((y - fsy)*(y - fsy));
+    const __m128 wt = _mm_set1_ps(invwt);
+    const __m128 step = _mm_set1_ps(4.0f);
+    const __m128i lab = _mm_set1_epi32(label);
+
+    int x = x1;
+    __m128 xv = _mm_set_ps(x+3, x+2, x+1, x);
+    for( ; x+4 <= x2; x += 4 )
+    {
+        int i = y*width + x;
+        //four interleaved pixels to one register per component
+        __m128 l = _mm_loadu_ps(&pixels[i].l);
+        __m128 a = _mm_loadu_ps(&pixels[i+1].l);
+        __m128 b = _mm_loadu_ps(&pixels[i+2].l);
+        __m128 old = _mm_loadu_ps(&pixels[i+3].l);
+        _MM_TRANSPOSE4_PS(l, a, b, old);
+
+        __m128 dl = _mm_sub_ps(l, sl);
+        __m128 da = _mm_sub_ps(a, sa);
+        __m128 db = _mm_sub_ps(b, sb);
+        __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dl,dl), _mm_mul_ps(da,da)), _mm_mul_ps(db,db));
+        __m128 dx = _mm_sub_ps(xv, sx);
+        __m128 distxy = _mm_add_ps(_mm_mul_ps(dx,dx), dy2);
+        dist = _mm_add_ps(dist, _mm_mul_ps(distxy, wt));
+
+        __m128 closer = _mm_cmplt_ps(dist, old);
+        int mask = _mm_movemask_ps(closer);
+        if( mask )
+        {
+            float d[4];
+            _mm_storeu_ps(d, _mm_blendv_ps(old, dist, closer));
+            for( int k = 0; k < 4; k++ ) pixels[i+k].dist = d[k];
+            __m128i* labels = (__m128i*)(klabels+i);
+            _mm_storeu_si128(labels, _mm_blendv_epi8(_mm_loadu_si128(labels), lab, _mm_castps_si128(closer)));
+        }
+        xv = _mm_add_ps(xv, step);
+    }
+    AssignRowSegmentScalar(pixels, klabels, width, y, x, x2, seed, invwt, label);
+}
+
+__attribute__((target("sse4.1")))
+static void AssignRowSegmentSSE41(const double* lvec, const double* avec, const double* bvec,
+                                  double* distvec, int* klabels,
+                                  int width, int y, int x1, int x2,
+                                  const SLICSeed& seed, double invwt, int label)
+{
+    const __m128d sl = _mm_set1_pd(seed.l);
+    const __m128d sa = _mm_set1_pd(seed.a);
+    const __m128d sb = _mm_set1_pd(seed.b);
+    const __m128d sx = _mm_set1_pd(seed.x);
+    const __m128d dy2 = _mm_set1_pd((y - seed.y)*(y - seed.y));
+    const __m128d wt = _mm_set1_pd(invwt);
+    const __m128d step = _mm_set1_pd(2.0);
+
+    int x = x1;
+    __m128d xv = _mm_set_pd(x+1, x);
+    for( ; x+2 <= x2; x += 2 )
+    {
+        int i = y*width + x;
+        __m128d dl = _mm_sub_pd(_mm_loadu_pd(lvec+i), sl);
+        __m128d da = _mm_sub_pd(_mm_loadu_pd(avec+i), sa);
+        __m128d db = _mm_sub_pd(_mm_loadu_pd(bvec+i), sb);
+        __m128d dist = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dl,dl), _mm_mul_pd(da,da)), _mm_mul_pd(db,db));
+        __m128d dx = _mm_sub_pd(xv, sx);
+        __m128d distxy = _mm_add_pd(_mm_mul_pd(dx,dx), dy2);
+        dist = _mm_add_pd(dist, _mm_mul_pd(distxy, wt));
+
+        __m128d old = _mm_loadu_pd(distvec+i);
+        __m128d closer = _mm_cmplt_pd(dist, old);
+        int mask = _mm_movemask_pd(closer);
+        if( mask )
+        {
+            _mm_storeu_pd(distvec+i, _mm_blendv_pd(old, dist, closer));
+            if( mask & 1 ) klabels[i] = label;
+            if( mask & 2 ) klabels[i+1] = label;
+        }
+        xv = _mm_add_pd(xv, step);
+    }
+    AssignRowSegmentScalar(lvec, avec, bvec, distvec, klabels, width, y, x, x2, seed, invwt, label);
+}
+
+__attribute__((target("avx2")))
+static void AssignRowSegmentAVX2(const double* lvec, const double* avec, const double* bvec,
+                                 double* distvec, int* klabels,
+                                 int width, int y, int x1, int x2,
+                                 const SLICSeed& seed, double invwt, int label)
+{
+    const __m256d sl = _mm256_set1_pd(seed.l);
+    const __m256d sa = _mm256_set1_pd(seed.a);
+    const __m256d sb = _mm256_set1_pd(seed.b);
+    const __m256d sx = _mm256_set1_pd(seed.x);
+    const __m256d dy2 = _mm256_set1_pd((y - seed.y)*(y - seed.y));
+    const __m256d wt = _mm256_set1_pd(invwt);
+    const __m256d step = _mm256_set1_pd(4.0);
+    const __m128i lab = _mm_set1_epi32(label);
+
+    int x = x1;
+    __m256d xv = _mm256_set_pd(x+3, x+2, x+1, x);
+    for( ; x+4 <= x2; x += 4 )
+    {
+        int i = y*width + x;
+        __m256d dl = _mm256_sub_pd(_mm256_loadu_pd(lvec+i), sl);
+        __m256d da = _mm256_sub_pd(_mm256_loadu_pd(avec+i), sa);
+        __m256d db = _mm256_sub_pd(_mm256_loadu_pd(bvec+i), sb);
+        __m256d dist = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dl,dl), _mm256_mul_pd(da,da)), _mm256_mul_pd(db,db));
+        __m256d dx = _mm256_sub_pd(xv, sx);
+        __m256d distxy = _mm256_add_pd(_mm256_mul_pd(dx,dx), dy2);
+        dist = _mm256_add_pd(dist, _mm256_mul_pd(distxy, wt));
+
+        __m256d old = _mm256_loadu_pd(distvec+i);
+        __m256d closer = _mm256_cmp_pd(dist, old, _CMP_LT_OQ);
+        if( !_mm256_testz_pd(closer, closer) )
+        {
+            _mm256_storeu_pd(distvec+i, _mm256_blendv_pd(old, dist, closer));
+            //narrow the four 64 bit lane masks to 32 bit lanes
+            __m128i closer32 = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(
+                                   _mm256_castpd_si256(closer), _mm256_set_epi32(7,5,3,1,6,4,2,0)));
+            __m128i* labels = (__m128i*)(klabels+i);
+            _mm_storeu_si128(labels, _mm_blendv_epi8(_mm_loadu_si128(labels), lab, closer32));
+        }
+        xv = _mm256_add_pd(xv, step);
+    }
+    AssignRowSegmentScalar(lvec, avec, bvec, distvec, klabels, width, y, x, x2, seed, invwt, label);
+}
+
+#endif
+
+void AssignRowSegment(SimdLevel level,
+                      const double* lvec, const double* avec, const double* bvec,
+                      double* distvec, int* klabels,
+                      int width, int y, int x1, int x2,
+                      const SLICSeed& seed, double invwt, int label)
+{
+#ifdef ASARI_X86_SIMD
+    if( level == SIMD_AVX2 )
+    {
+        AssignRowSegmentAVX2(lvec, avec, bvec, distvec, klabels, width, y, x1, x2, seed, invwt, label);
+        return;
+    }
+    if( level == SIMD_SSE41 )
+    {
+        AssignRowSegmentSSE41(lvec, avec, bvec, distvec, klabels, width, y, x1, x2, seed, invwt, label);
+        return;
+    }
+#endif
+    AssignRowSegmentScalar(lvec, avec, bvec, distvec, klabels, width, y, x1, x2, seed, invwt, label);
+}
+
+void AssignRowSegment(SimdLevel level,
+                      LABDPixel* pixels, int* klabels,
+                      int width, int y, int x1, int x2,
+                      const SLICSeed& seed, double invwt, int label)
+{
+#ifdef ASARI_X86_SIMD
+    if( level >= SIMD_SSE41 )
+    {
+        AssignRowSegmentSSE41(pixels, klabels, width, y, x1, x2, seed, invwt, label);
+        return;
+    }
+#endif
+    AssignRowSegmentScalar(pixels, klabels, width, y, x1, x2, seed, invwt, label);
+}
@@ -0,0 +1,60 @@
+#include "sweep.h"
+#include "asari.h"
+#include "parallel.h"
+
+#include <chrono>
+#include <sstream>
+
+static double secondsSince(chrono::steady_clock::time_point start){
+    return chrono::duration<double>(chrono::steady_clock::now()-start).count();
+}
+
+vector<SweepResult> sweepParameters(Image image, const vector<Parameters>& configurations, bool useTexture,
+                                    int nbThreads, const string& resPrefix){
+    vector<SweepResult> results(configurations.size());
+
+    //group configurations sharing slic and LTP
+    vector<vector<int> > groups;
+    for(unsigned int i=0;i<configurations.size();i++){
+        unsigned int g=0;
+        while(g<groups.size() && !(configurations[groups[g][0]].sameSlic(configurations[i])
+                                   && configurations[groups[g][0]].sameLtp(configurations[i]))){
+            g++;
+        }
+        if(g==groups.size()) groups.push_back(vector<int>());
+        groups[g].push_back(i);
+    }
+
+    for(unsigned int g=0;g<groups.size();g++){
+        const vector<int>& group=groups[g];
+        Parameters param=configurations[group[0]];
+        chrono::steady_clock::time_point start=chrono::steady_clock::now();
+        Asari initial(param,image,IMAGE_BORROW,useTexture);
+        double initializationTime=secondsSince(start);
+
+        //each thread merges from its own copy of the initial superpixels
+        int nbWorkers=min(resolveNbThreads(nbThreads),(int)group.size());
+        parallelFor(nbWorkers,nbWorkers,[&](int worker){
+            Asari asari=initial.copy();
+            for(unsigned int j=worker;j<group.size();j+=nbWorkers){
+                SweepResult& result=results[group[j]];
+                result.param=configurations[group[j]];
+                chrono::steady_clock::time_point mergingStart=chrono::steady_clock::now();
+                asari.changeParam(result.param);
+                asari.compute();
+                result.mergingTime=secondsSince(mergingStart);
+                result.group=g;
+                result.nbSuperpixels=asari.getNbSp();
+                result.labels=asari.getSuperpixels();
+                result.initializationTime=initializationTime;
+
+                if(!resPrefix.empty()){
+                    ostringstream path;
+                    path << resPrefix << group[j] << ".ppm";
+                    ImWrite(asari.getResult(),path.str().c_str());
+                }
+            }
+        });
+    }
+    return results;
+}